@@ -4,12 +4,48 @@ Analyze Polaris simulation statistics
 """
 import pandas as pd
 import matplotlib.pyplot as plt
+import numpy as np
+import os
+import struct
 import sys
 
+def load_stats(path):
+    """Load a statistics file written as CSV or in the binary columnar format"""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if not data.startswith(b'PLSTATS\0'):
+        return pd.read_csv(path)
+
+    # Header: magic, version, column count, then (type, name length, name) per column
+    version, count = struct.unpack_from('<II', data, 8)
+    if version != 1:
+        raise ValueError(f"{path}: unsupported statistics version {version}")
+    pos = 16
+    columns = []
+    for _ in range(count):
+        kind, length = data[pos], data[pos + 1]
+        name = data[pos + 2:pos + 2 + length].decode()
+        columns.append((name, np.dtype('<f8' if kind == ord('d') else '<i4')))
+        pos += 2 + length
+
+    # Blocks: row count, then each column's values; a truncated last block is dropped
+    parts = {name: [] for name, _ in columns}
+    while pos + 4 <= len(data):
+        (rows,) = struct.unpack_from('<I', data, pos)
+        size = sum(rows * dtype.itemsize for _, dtype in columns)
+        if pos + 4 + size > len(data):
+            break
+        pos += 4
+        for name, dtype in columns:
+            parts[name].append(np.frombuffer(data, dtype, rows, pos))
+            pos += rows * dtype.itemsize
+    return pd.DataFrame({name: np.concatenate(chunks) if chunks else np.array([], dtype)
+                         for (name, dtype), chunks in zip(columns, parts.values())})
+
 def plot_population(csv_file='stats.csv'):
     """Plot population dynamics over time"""
     try:
-        df = pd.read_csv(csv_file)
+        df = load_stats(csv_file)
     except FileNotFoundError:
         print(f"Error: {csv_file} not found. Run the simulation first!")
         return
@@ -63,7 +99,7 @@ def plot_population(csv_file='stats.csv'):
     plt.tight_layout()
     
     # Save figure
-    output_file = csv_file.replace('.csv', '_analysis.png')
+    output_file = os.path.splitext(csv_file)[0] + '_analysis.png'
     plt.savefig(output_file, dpi=150)
     print(f"✅ Analysis saved to {output_file}")
     
@@ -72,7 +108,7 @@ def plot_population(csv_file='stats.csv'):
 def print_summary(csv_file='stats.csv'):
     """Print statistical summary"""
     try:
-        df = pd.read_csv(csv_file)
+        df = load_stats(csv_file)
     except FileNotFoundError:
         print(f"Error: {csv_file} not found. Run the simulation first!")
         return
@@ -98,6 +134,11 @@ def print_summary(csv_file='stats.csv'):
     print(f"   Avg (final):      {df['avg_energy'].iloc[-1]:.2f}")
     print(f"   Avg Predator:     {df['avg_predator_energy'].mean():.2f}")
     print(f"   Avg Prey:         {df['avg_prey_energy'].mean():.2f}")
+    if 'energy_p50' in df:
+        print(f"   Final p10/p50/p90: {df['energy_p10'].iloc[-1]:.1f} / {df['energy_p50'].iloc[-1]:.1f} / {df['energy_p90'].iloc[-1]:.1f}")
+        print(f"\n🧬 Final distributions (p50 / p90):")
+        print(f"   Age:        {df['age_p50'].iloc[-1]:.0f} / {df['age_p90'].iloc[-1]:.0f}")
+        print(f"   Generation: {df['generation_p50'].iloc[-1]:.0f} / {df['generation_p90'].iloc[-1]:.0f}")
     
     # Extinction check
     if df['total_agents'].iloc[-1] == 0:
@@ -0,0 +1,113 @@
+#include "agent_store.hpp"
+#include <algorithm>
+
+void AgentStore::reserve(size_t n) {
+    pos_x.reserve(n); pos_y.reserve(n);
+    vel_x.reserve(n); vel_y.reserve(n);
+    energy.reserve(n);
+    predator.reserve(n);
+    flags.reserve(n);
+    id.reserve(n);
+    fitness.reserve(n);
+    age.reserve(n);
+    kills.reserve(n);
+    generation.reserve(n);
+    brain.reserve(n);
+}
+
+void AgentStore::resize(size_t n) {
+    pos_x.resize(n, 0.0); pos_y.resize(n, 0.0);
+    vel_x.resize(n, 0.0); vel_y.resize(n, 0.0);
+    energy.resize(n, 100.0);
+    predator.resize(n, 0);
+    flags.resize(n, FLAG_ALIVE);
+    id.resize(n, 0);
+    fitness.resize(n, 0.0);
+    age.resize(n, 0);
+    kills.resize(n, 0);
+    generation.resize(n, 0);
+    brain.resize(n, NO_BRAIN);
+    trails.resize(n);
+}
+
+void AgentStore::clear() {
+    resize(0);
+}
+
+size_t AgentStore::add(uint64_t agent_id, const Vec2& p, const Vec2& v, bool is_predator, Real e, int gen) {
+    const size_t idx = size();
+    pos_x.push_back(p.x); pos_y.push_back(p.y);
+    vel_x.push_back(v.x); vel_y.push_back(v.y);
+    energy.push_back(e);
+    predator.push_back(is_predator ? 1 : 0);
+    flags.push_back(FLAG_ALIVE);
+    id.push_back(agent_id);
+    fitness.push_back(0.0);
+    age.push_back(0);
+    kills.push_back(0);
+    generation.push_back(gen);
+    brain.push_back(NO_BRAIN);
+    trails.resize(idx + 1);
+    return idx;
+}
+
+// Stable in-place compaction of one column against the (not yet compacted) flags
+template <typename T>
+static void compact_column(std::vector<T>& column, const std::vector<uint8_t>& flags, size_t live) {
+    size_t w = 0;
+    for (size_t r = 0; r < column.size(); ++r) {
+        if (!(flags[r] & AgentStore::FLAG_ALIVE)) continue;
+        if (w != r) column[w] = std::move(column[r]);
+        ++w;
+    }
+    column.resize(live);
+}
+
+void AgentStore::remove_dead() {
+    const size_t live = std::count_if(flags.begin(), flags.end(),
+                                      [](uint8_t f) { return f & FLAG_ALIVE; });
+    if (live == size()) return;
+
+    compact_column(pos_x, flags, live);
+    compact_column(pos_y, flags, live);
+    compact_column(vel_x, flags, live);
+    compact_column(vel_y, flags, live);
+    compact_column(energy, flags, live);
+    compact_column(predator, flags, live);
+    compact_column(id, flags, live);
+    compact_column(fitness, flags, live);
+    compact_column(age, flags, live);
+    compact_column(kills, flags, live);
+    compact_column(generation, flags, live);
+    compact_column(brain, flags, live);
+    trails.remove_dead(flags, FLAG_ALIVE, live);
+
+    // Flags go last since every other column is filtered against them
+    // (compacting in place is safe: slot w is only written after it was read)
+    compact_column(flags, flags, live);
+}
+
+Agent AgentStore::materialize(size_t i) const {
+    Agent a;
+    a.id = id[i];
+    a.pos = pos(i);
+    a.vel = vel(i);
+    a.predator = predator[i] != 0;
+    a.energy = energy[i];
+    a.alive = alive(i);
+    a.fitness = fitness[i];
+    a.age = age[i];
+    a.kills = kills[i];
+    a.generation = generation[i];
+    a.has_brain = brain[i] != NO_BRAIN;
+    return a;
+}
+
+std::vector<Agent> AgentStore::materialize() const {
+    std::vector<Agent> out;
+    out.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        out.push_back(materialize(i));
+    }
+    return out;
+}
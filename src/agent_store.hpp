@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "agent.hpp"
+#include "brain_pool.hpp"
+#include "trail_buffer.hpp"
+
+/**
+ * @brief Structure-of-arrays storage for the agent population.
+ *
+ * Every field lives in its own contiguous column, indexed by agent slot, so a
+ * phase that only needs positions and velocities streams four Reals per agent
+ * instead of dragging whole agent objects through the cache. Cold data
+ * (brains, trails) sits in separate columns that hot loops never touch.
+ */
+struct AgentStore {
+    static constexpr uint8_t FLAG_ALIVE = 1 << 0;
+
+    // Hot columns
+    std::vector<Real> pos_x, pos_y;
+    std::vector<Real> vel_x, vel_y;
+    std::vector<Real> energy;
+    std::vector<uint8_t> predator;
+    std::vector<uint8_t> flags;
+
+    // Lifetime / evolution columns
+    std::vector<uint64_t> id;  // Stable identity; keys the agent's random streams
+    std::vector<Real> fitness;
+    std::vector<int> age;
+    std::vector<int> kills;
+    std::vector<int> generation;
+
+    // Cold columns
+    std::vector<BrainHandle> brain;  // Block in World::brains, or NO_BRAIN
+    TrailBuffer trails;              // Movement history for visualization (empty when off)
+
+    [[nodiscard]] size_t size() const { return pos_x.size(); }
+    [[nodiscard]] bool empty() const { return pos_x.empty(); }
+    [[nodiscard]] bool alive(size_t i) const { return flags[i] & FLAG_ALIVE; }
+    [[nodiscard]] Vec2 pos(size_t i) const { return {pos_x[i], pos_y[i]}; }
+    [[nodiscard]] Vec2 vel(size_t i) const { return {vel_x[i], vel_y[i]}; }
+
+    void kill(size_t i) { flags[i] &= static_cast<uint8_t>(~FLAG_ALIVE); }
+
+    void reserve(size_t n);
+    void resize(size_t n);
+    void clear();
+
+    // Append a live agent without a brain and return its slot
+    size_t add(uint64_t agent_id, const Vec2& p, const Vec2& v, bool is_predator, Real e, int gen);
+
+    // Drop dead agents, preserving the relative order of survivors. Their
+    // brain handles are dropped too; release them from the pool first.
+    void remove_dead();
+
+    // Build per-agent views (copies) for external consumers
+    Agent materialize(size_t i) const;
+    std::vector<Agent> materialize() const;
+};
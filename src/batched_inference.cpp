@@ -0,0 +1,18 @@
+#include "batched_inference.hpp"
+#include "thread_pool.hpp"
+
+BatchedInference::BatchedInference(const NetworkShape& shape, NetworkBatchKernel kernel)
+    : shape_(shape), kernel_(kernel ? kernel : select_network_kernel(shape)) {}
+
+void BatchedInference::resize(size_t rows) {
+    // Buffers only grow, so a steady population never reallocates
+    inputs_.resize(rows * shape_.input);
+    outputs_.resize(rows * shape_.output);
+    params_.assign(rows, nullptr);
+}
+
+void BatchedInference::run(ThreadPool& pool) {
+    pool.parallel_for(params_.size(), [&](size_t begin, size_t end) {
+        kernel_(shape_, params_.data(), inputs_.data(), outputs_.data(), begin, end);
+    }, 256);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include "fixed_network.hpp"
+
+class ThreadPool;
+
+/**
+ * @brief Population-wide neural network evaluation.
+ *
+ * Holds an input matrix (rows x shape.input) and output matrix
+ * (rows x shape.output) that persist across steps, plus one parameter block
+ * pointer per row. A caller fills the rows it wants evaluated, leaves the
+ * rest without parameters, and run() evaluates every bound row in one
+ * parallel pass. The kernel is picked once, at construction: the FixedNetwork
+ * registered for the shape if there is one, otherwise network_forward().
+ *
+ * Example usage:
+ *
+ * BatchedInference batch({8, 12, 2});
+ * batch.resize(agents.size());
+ * for (i...) { fill(batch.input_row(i)); batch.bind(i, brain.params()); }
+ * batch.run(pool);
+ * use(batch.output_row(i));
+ */
+class BatchedInference {
+public:
+    // kernel overrides the choice of select_network_kernel()
+    explicit BatchedInference(const NetworkShape& shape, NetworkBatchKernel kernel = nullptr);
+
+    // Size the batch to rows entries; every row starts unbound
+    void resize(size_t rows);
+
+    // Attach a packed parameter block (nullptr skips the row)
+    void bind(size_t row, const Real* params) { params_[row] = params; }
+
+    Real* input_row(size_t row) { return inputs_.data() + row * shape_.input; }
+    const Real* output_row(size_t row) const { return outputs_.data() + row * shape_.output; }
+
+    // Evaluate all bound rows
+    void run(ThreadPool& pool);
+
+    [[nodiscard]] const NetworkShape& shape() const { return shape_; }
+    [[nodiscard]] size_t rows() const { return params_.size(); }
+    [[nodiscard]] bool specialized() const { return kernel_ != &network_forward_rows; }
+
+private:
+    NetworkShape shape_;
+    NetworkBatchKernel kernel_;
+    std::vector<Real> inputs_;
+    std::vector<Real> outputs_;
+    std::vector<const Real*> params_;
+};
@@ -0,0 +1,437 @@
+// Benchmark suite: times the hot paths of the engine in isolation and as
+// whole simulation steps, and writes the results as JSON so runs from
+// different commits can be compared.
+#include "world.hpp"
+#include "config.hpp"
+#include "statistics.hpp"
+#include "spatial_grid.hpp"
+#include "neural_network.hpp"
+#include "brain_pool.hpp"
+#include "batched_inference.hpp"
+#include "thread_pool.hpp"
+#include "simd.hpp"
+#include "json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchOptions {
+    size_t max_agents = 1000000;
+    int threads = 0;
+    double min_seconds = 0.25;  // Minimum measuring time per micro benchmark
+    std::string filter;         // Only run benchmarks whose name contains this
+    std::string json_path = "bench.json";
+};
+
+struct BenchResult {
+    std::string name;
+    size_t agents = 0;       // Problem size the op covers (1 for single-network ops)
+    size_t iterations = 0;
+    double ns_median = 0.0;  // Per op
+    double ns_min = 0.0;
+};
+
+std::vector<BenchResult> g_results;
+volatile size_t g_sink = 0;  // Keeps query results observable to the optimizer
+
+double elapsed_ns(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+void report(const BenchResult& r) {
+    g_results.push_back(r);
+    std::cout << std::left << std::setw(34) << r.name
+              << std::right << std::setw(9) << r.agents
+              << std::setw(14) << std::fixed << std::setprecision(1) << r.ns_median
+              << std::setw(12) << std::setprecision(2) << r.ns_median / std::max<size_t>(r.agents, 1)
+              << std::setw(8) << r.iterations << "\n";
+}
+
+// Median and minimum of per-iteration samples
+void summarize(std::vector<double>& samples, BenchResult& r) {
+    std::sort(samples.begin(), samples.end());
+    r.iterations = samples.size();
+    r.ns_min = samples.front();
+    r.ns_median = samples[samples.size() / 2];
+}
+
+// Time fn() repeatedly, after one warm-up call, for at least min_seconds and
+// min_iters iterations. fn does one op; batch_size ops may be grouped per
+// sample to keep timer overhead out of very short ops.
+template <class Fn>
+void measure(const BenchOptions& opt, const std::string& name, size_t agents, Fn&& fn,
+             size_t batch_size = 1, size_t min_iters = 5) {
+    fn();
+
+    std::vector<double> samples;
+    const auto start = Clock::now();
+    while (samples.size() < min_iters || elapsed_ns(start) < opt.min_seconds * 1e9) {
+        const auto t0 = Clock::now();
+        for (size_t b = 0; b < batch_size; ++b) fn();
+        samples.push_back(elapsed_ns(t0) / batch_size);
+    }
+
+    BenchResult r;
+    r.name = name;
+    r.agents = agents;
+    summarize(samples, r);
+    report(r);
+}
+
+bool selected(const BenchOptions& opt, const std::string& name) {
+    return opt.filter.empty() || name.find(opt.filter) != std::string::npos;
+}
+
+std::vector<size_t> agent_counts(const BenchOptions& opt) {
+    std::vector<size_t> counts;
+    for (size_t n : {1000, 10000, 100000, 1000000}) {
+        if (n <= opt.max_agents) counts.push_back(n);
+    }
+    return counts;
+}
+
+// Scale a world to n agents at a fixed density (0.25 agents per unit area),
+// so neighbour counts per agent stay the same at every size and the cost of
+// a step is expected to grow linearly in n
+SimulationConfig bench_config(size_t n, bool enable_ai, int threads) {
+    SimulationConfig cfg = SimulationConfig::create_default();
+    cfg.num_agents = static_cast<int>(n);
+    cfg.num_threads = threads;
+    cfg.enable_ai = enable_ai;
+    cfg.enable_stats = false;
+    cfg.boundary = std::sqrt(n / 0.25) / 2.0;
+
+    // Cells about one interaction radius wide
+    const double radius = std::sqrt(cfg.interaction_range);
+    cfg.grid_cells = std::max(1, static_cast<int>(2.0 * cfg.boundary / radius));
+    return cfg;
+}
+
+// --- Spatial grid ---
+
+void bench_grid(const BenchOptions& opt) {
+    for (size_t n : agent_counts(opt)) {
+        // Average agents per cell
+        for (double density : {1.0, 8.0, 32.0}) {
+            const int cells = std::max(1, static_cast<int>(std::sqrt(n / density)));
+            const double world_size = cells * 2.0;  // Cells are 4 units wide
+            SpatialGrid grid(world_size, cells);
+
+            std::mt19937 rng(1234);
+            std::uniform_real_distribution<double> dist(-world_size, world_size);
+            std::vector<Real> xs(n), ys(n);
+            std::vector<uint8_t> predator(n);
+            for (size_t i = 0; i < n; ++i) {
+                xs[i] = dist(rng);
+                ys[i] = dist(rng);
+                predator[i] = (i % 4 == 0);
+            }
+
+            const std::string suffix = "/d" + std::to_string(static_cast<int>(density));
+            auto include_all = [](size_t) { return true; };
+
+            if (selected(opt, "grid_rebuild" + suffix)) {
+                measure(opt, "grid_rebuild" + suffix, n, [&]() {
+                    grid.rebuild(xs.data(), ys.data(), n, include_all);
+                });
+            }
+            if (selected(opt, "grid_update" + suffix)) {
+                // One step of motion at the default dt and top speed; the
+                // positions alternate so every call sees the same churn
+                std::vector<Real> xs2 = xs, ys2 = ys;
+                for (size_t i = 0; i < n; ++i) {
+                    xs2[i] = static_cast<Real>(std::clamp(xs[i] + 0.2 * dist(rng) / world_size, -world_size, world_size));
+                    ys2[i] = static_cast<Real>(std::clamp(ys[i] + 0.2 * dist(rng) / world_size, -world_size, world_size));
+                }
+                grid.rebuild(xs.data(), ys.data(), n, include_all);
+                bool flip = false;
+                measure(opt, "grid_update" + suffix, n, [&]() {
+                    flip = !flip;
+                    grid.update(flip ? xs2.data() : xs.data(), flip ? ys2.data() : ys.data(), n, include_all);
+                });
+            }
+            grid.rebuild(xs.data(), ys.data(), n, include_all);
+
+            if (selected(opt, "grid_radius" + suffix)) {
+                measure(opt, "grid_radius" + suffix, n, [&]() {
+                    size_t visited = 0;
+                    for (size_t i = 0; i < n; ++i) {
+                        grid.for_each_in_radius({xs[i], ys[i]}, 4.0, [&](size_t) { ++visited; });
+                    }
+                    g_sink = visited;
+                });
+            }
+
+            if (selected(opt, "grid_nearest" + suffix)) {
+                measure(opt, "grid_nearest" + suffix, n, [&]() {
+                    size_t found = 0;
+                    for (size_t i = 0; i < n; ++i) {
+                        NearestHit hits[2];
+                        grid.query_nearest_per_class({xs[i], ys[i]}, xs.data(), ys.data(),
+                            [&](size_t j) { return j == i ? -1 : int(predator[j]); },
+                            hits, 2, 0b11u);
+                        found += hits[0].index + hits[1].index;
+                    }
+                    g_sink = found;
+                });
+            }
+        }
+    }
+}
+
+// --- Neural networks ---
+
+void bench_network(const BenchOptions& opt, ThreadPool& pool) {
+    const SimulationConfig cfg = SimulationConfig::create_default();
+    const NetworkShape shape{cfg.neural_input_size, cfg.neural_hidden_size, cfg.neural_output_size};
+    NeuralNetwork brain(shape.input, shape.hidden, shape.output, 7);
+
+    std::vector<Real> inputs(shape.input, Real(0.3)), outputs(shape.output), scratch(shape.hidden);
+
+    if (selected(opt, "nn_forward")) {
+        measure(opt, "nn_forward", 1, [&]() {
+            brain.forward(inputs.data(), outputs.data(), scratch.data());
+            g_sink = static_cast<size_t>(outputs[0] > 0.0);
+        }, 1000);
+    }
+    if (selected(opt, "nn_forward_fixed") && find_fixed_network_kernel(shape)) {
+        // The same network through the compile-time kernel dispatched for it
+        const NetworkBatchKernel kernel = find_fixed_network_kernel(shape);
+        const Real* params = brain.params();
+        measure(opt, "nn_forward_fixed", 1, [&]() {
+            kernel(shape, &params, inputs.data(), outputs.data(), 0, 1);
+            g_sink = static_cast<size_t>(outputs[0] > 0.0);
+        }, 1000);
+    }
+    if (selected(opt, "nn_mutate")) {
+        measure(opt, "nn_mutate", 1, [&]() {
+            brain.mutate(cfg.mutation_rate, cfg.mutation_strength);
+        }, 100);
+    }
+    if (selected(opt, "nn_clone")) {
+        measure(opt, "nn_clone", 1, [&]() {
+            auto copy = std::make_unique<NeuralNetwork>(brain.clone());
+            g_sink = static_cast<size_t>(copy->params()[0] > 0.0);
+        }, 1000);
+    }
+    if (selected(opt, "brain_pool_clone")) {
+        // Counterpart of nn_clone: a birth and a death through the pool
+        BrainPool brains(shape);
+        const BrainHandle parent = brains.create(CounterRng(7, 0, 0, RngStream::BrainInit));
+        measure(opt, "brain_pool_clone", 1, [&]() {
+            const BrainHandle child = brains.clone(parent);
+            g_sink = static_cast<size_t>(brains.params(child)[0] > 0.0);
+            brains.release(child);
+        }, 1000);
+    }
+
+    for (size_t n : agent_counts(opt)) {
+        if (!selected(opt, "nn_batch")) continue;
+
+        // Distinct parameter blocks so the batch streams real memory
+        std::vector<NeuralNetwork> brains;
+        const size_t distinct = std::min<size_t>(n, 65536);
+        brains.reserve(distinct);
+        for (size_t i = 0; i < distinct; ++i) {
+            brains.emplace_back(shape.input, shape.hidden, shape.output, static_cast<unsigned>(i));
+        }
+
+        BatchedInference batch(shape);
+        batch.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            std::fill_n(batch.input_row(i), shape.input, 0.1 * (i % 10));
+            batch.bind(i, brains[i % distinct].params());
+        }
+        measure(opt, "nn_batch", n, [&]() { batch.run(pool); });
+
+        if (batch.specialized() && selected(opt, "nn_batch_generic")) {
+            BatchedInference generic(shape, &network_forward_rows);
+            generic.resize(n);
+            for (size_t i = 0; i < n; ++i) {
+                std::copy_n(batch.input_row(i), shape.input, generic.input_row(i));
+                generic.bind(i, brains[i % distinct].params());
+            }
+            measure(opt, "nn_batch_generic", n, [&]() { generic.run(pool); });
+        }
+    }
+}
+
+}  // namespace
+
+// --- World phases ---
+
+// Steps a world phase by phase, in the same order as World::update
+struct WorldPhaseBench {
+    static void run(const BenchOptions& opt, size_t n, bool enable_ai) {
+        const std::string prefix = enable_ai ? "world_ai/" : "world_noai/";
+        if (!selected(opt, prefix)) return;
+
+        SimulationConfig cfg = bench_config(n, enable_ai, opt.threads);
+        World world(cfg, 42);
+        const double dt = cfg.dt;
+
+        const char* names[] = {"rebuild_grid", "neural_control", "interactions",
+                               "movement", "energy_reproduction", "remove_dead",
+                               "fitness", "update"};
+        constexpr int num_phases = 8;
+        std::vector<double> samples[num_phases];
+        std::vector<double> populations;
+
+        // Enough steps to average out births and deaths, bounded for large n
+        const int steps = static_cast<int>(std::clamp<size_t>(5000000 / n, 3, 20));
+        for (int step = 0; step < steps; ++step) {
+            const double agents = std::max<double>(world.agents.size(), 1.0);
+            populations.push_back(agents);
+            double t[num_phases] = {};
+
+            auto phase = [&](int p, auto&& fn) {
+                const auto t0 = Clock::now();
+                fn();
+                t[p] = elapsed_ns(t0);
+                t[num_phases - 1] += t[p];
+            };
+
+            phase(0, [&]() { world.rebuild_grid(); });
+            if (world.config->enable_ai) phase(1, [&]() { world.apply_neural_control(dt); });
+            phase(2, [&]() { world.handle_interactions(dt); });
+            phase(3, [&]() { world.integrate_movement(dt); });
+            phase(4, [&]() { world.handle_energy_and_reproduction(dt); });
+            phase(5, [&]() { world.remove_dead_agents(); });
+            phase(6, [&]() { world.update_fitness(); });
+
+            // Normalise to the initial size so results compare across steps
+            for (int p = 0; p < num_phases; ++p) samples[p].push_back(t[p] * n / agents);
+        }
+
+        for (int p = 0; p < num_phases; ++p) {
+            if (p == 1 && !enable_ai) continue;
+            BenchResult r;
+            r.name = prefix + names[p];
+            r.agents = n;
+            summarize(samples[p], r);
+            report(r);
+        }
+
+        // Movement with trail recording, once the trails have filled up
+        if (selected(opt, prefix + "movement_trails")) {
+            world.config->show_trails = true;
+            for (int i = 0; i < world.config->trail_length; ++i) world.integrate_movement(dt);
+            measure(opt, prefix + "movement_trails", world.agents.size(), [&]() {
+                world.integrate_movement(dt);
+            });
+            world.config->show_trails = false;
+            world.integrate_movement(dt);
+        }
+
+        // Statistics snapshot over the same population
+        if (selected(opt, "stats_record_step") && !enable_ai) {
+            const auto path = std::filesystem::temp_directory_path() / "polaris_bench_stats.csv";
+            {
+                Statistics stats(path.string(), true);
+                int step = 0;
+                measure(opt, "stats_record_step", world.agents.size(), [&]() {
+                    stats.record_step(step, step * dt, world);
+                    ++step;
+                });
+            }
+            std::filesystem::remove(path);
+        }
+    }
+};
+
+namespace {
+
+void print_usage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [options]\n"
+              << "\n"
+              << "Options:\n"
+              << "  --max-agents N   Largest population to benchmark (default 1000000)\n"
+              << "  --threads N      Worker threads (0 = all cores)\n"
+              << "  --min-time S     Minimum seconds per micro benchmark (default 0.25)\n"
+              << "  --filter TEXT    Only run benchmarks whose name contains TEXT\n"
+              << "  --json FILE      Write results to FILE (default bench.json)\n"
+              << "  -h, --help       Show this message\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "[Bench] Missing value for " << arg << "\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-h" || arg == "--help") { print_usage(argv[0]); return 0; }
+        else if (arg == "--max-agents") opt.max_agents = std::strtoull(value(), nullptr, 10);
+        else if (arg == "--threads") opt.threads = std::atoi(value());
+        else if (arg == "--min-time") opt.min_seconds = std::atof(value());
+        else if (arg == "--filter") opt.filter = value();
+        else if (arg == "--json") opt.json_path = value();
+        else {
+            std::cerr << "[Bench] Unknown option: " << arg << "\n";
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    ThreadPool pool(opt.threads);
+    const char* precision = sizeof(Real) == sizeof(float) ? "float" : "double";
+    std::cout << "[Bench] SIMD: " << POLARIS_SIMD_NAME << " (" << precision << "), threads: " << pool.size() << "\n\n";
+    std::cout << std::left << std::setw(34) << "benchmark"
+              << std::right << std::setw(9) << "agents"
+              << std::setw(14) << "ns/op"
+              << std::setw(12) << "ns/agent"
+              << std::setw(8) << "iters" << "\n";
+
+    bench_grid(opt);
+    bench_network(opt, pool);
+    for (size_t n : agent_counts(opt)) {
+        WorldPhaseBench::run(opt, n, false);
+        WorldPhaseBench::run(opt, n, true);
+    }
+
+    json j;
+    j["simd"] = POLARIS_SIMD_NAME;
+    j["precision"] = precision;
+    j["threads"] = pool.size();
+    j["results"] = json::array();
+    for (const auto& r : g_results) {
+        j["results"].push_back({
+            {"name", r.name},
+            {"agents", r.agents},
+            {"iterations", r.iterations},
+            {"ns_median", r.ns_median},
+            {"ns_min", r.ns_min},
+            {"ns_per_agent", r.ns_median / std::max<size_t>(r.agents, 1)}
+        });
+    }
+
+    std::ofstream out(opt.json_path);
+    if (!out.is_open()) {
+        std::cerr << "[Bench] Failed to open " << opt.json_path << "\n";
+        return 1;
+    }
+    out << j.dump(2) << "\n";
+    std::cout << "\n[Bench] Results written to " << opt.json_path << "\n";
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "brain_pool.hpp"
+#include <cstring>
+
+BrainPool::BrainPool(const NetworkShape& shape, size_t slab_brains)
+    : shape_(shape),
+      param_count_(shape.param_count()),
+      slab_brains_(slab_brains > 0 ? slab_brains : 1) {
+    constexpr size_t per_line = SLAB_ALIGN / sizeof(Real);
+    stride_ = (param_count_ + per_line - 1) / per_line * per_line;
+    if (stride_ == 0) stride_ = per_line;
+}
+
+void BrainPool::add_slab() {
+    const size_t reals = slab_brains_ * stride_;
+    Real* slab = static_cast<Real*>(
+        ::operator new[](reals * sizeof(Real), std::align_val_t{SLAB_ALIGN}));
+    slabs_.emplace_back(slab);
+}
+
+BrainHandle BrainPool::allocate() {
+    live_++;
+    if (!free_.empty()) {
+        const BrainHandle h = free_.back();
+        free_.pop_back();
+        return h;
+    }
+    if (next_ == capacity()) add_slab();
+    return next_++;
+}
+
+BrainHandle BrainPool::create(CounterRng rng) {
+    const BrainHandle h = allocate();
+    init(h, rng);
+    return h;
+}
+
+BrainHandle BrainPool::clone(BrainHandle src) {
+    const BrainHandle h = allocate();
+    copy(h, src);
+    return h;
+}
+
+void BrainPool::copy(BrainHandle dst, BrainHandle src) {
+    std::memcpy(params(dst), params(src), param_count_ * sizeof(Real));
+}
+
+void BrainPool::release(BrainHandle h) {
+    if (h == NO_BRAIN) return;
+    free_.push_back(h);
+    live_--;
+}
+
+void BrainPool::clear() {
+    free_.clear();
+    next_ = 0;
+    live_ = 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include "neural_network.hpp"
+
+// Index of a parameter block in a BrainPool
+using BrainHandle = uint32_t;
+constexpr BrainHandle NO_BRAIN = UINT32_MAX;
+
+/**
+ * @brief Slab allocator for the packed parameter blocks of every brain.
+ *
+ * All brains in a world share one NetworkShape, so each one is a fixed-size
+ * block of Reals. The pool hands those blocks out from 64-byte aligned slabs
+ * of slab_brains blocks each and recycles released slots through a free list,
+ * so a birth is a free-list pop plus one memcpy and a death is a push, with no
+ * heap traffic once the population has reached its working size. Slabs are
+ * never moved or freed while the pool lives, so params() pointers stay valid
+ * across growth.
+ *
+ * allocate(), clone() and release() touch the free list and must be called
+ * from one thread at a time. params(), copy(), init() and mutate() only touch
+ * the given blocks and may run in parallel on distinct handles.
+ *
+ * Example usage:
+ *
+ * BrainPool pool({8, 12, 2});
+ * BrainHandle parent = pool.create(CounterRng(seed, id, step, RngStream::BrainInit));
+ * BrainHandle child = pool.clone(parent);
+ * pool.mutate(child, rate, strength, CounterRng(seed, child_id, step, RngStream::Mutation));
+ * batch.bind(i, pool.params(child));
+ * pool.release(child);
+ */
+class BrainPool {
+public:
+    explicit BrainPool(const NetworkShape& shape, size_t slab_brains = 1024);
+
+    BrainPool(const BrainPool&) = delete;
+    BrainPool& operator=(const BrainPool&) = delete;
+
+    // Reserve a block with unspecified contents
+    BrainHandle allocate();
+
+    // Allocate and Xavier-initialize
+    BrainHandle create(CounterRng rng);
+
+    // Allocate a copy of src
+    BrainHandle clone(BrainHandle src);
+
+    // Return h to the free list
+    void release(BrainHandle h);
+
+    // Release every block; slabs are kept for reuse
+    void clear();
+
+    Real* params(BrainHandle h) {
+        return slabs_[h / slab_brains_].get() + (h % slab_brains_) * stride_;
+    }
+    const Real* params(BrainHandle h) const {
+        return slabs_[h / slab_brains_].get() + (h % slab_brains_) * stride_;
+    }
+
+    void copy(BrainHandle dst, BrainHandle src);
+    void init(BrainHandle h, CounterRng rng) { network_init(shape_, params(h), rng); }
+    void mutate(BrainHandle h, double rate, double strength, CounterRng rng) {
+        network_mutate(shape_, params(h), rate, strength, rng);
+    }
+
+    [[nodiscard]] const NetworkShape& shape() const { return shape_; }
+    [[nodiscard]] size_t live() const { return live_; }
+    [[nodiscard]] size_t capacity() const { return slabs_.size() * slab_brains_; }
+
+private:
+    static constexpr size_t SLAB_ALIGN = 64;
+
+    struct SlabDeleter {
+        void operator()(Real* p) const { ::operator delete[](p, std::align_val_t{SLAB_ALIGN}); }
+    };
+
+    NetworkShape shape_;
+    size_t param_count_;
+    size_t stride_;       // Reals per block, padded to a whole number of cache lines
+    size_t slab_brains_;  // Blocks per slab
+    std::vector<std::unique_ptr<Real[], SlabDeleter>> slabs_;
+    std::vector<BrainHandle> free_;  // Released blocks, reused most recent first
+    BrainHandle next_ = 0;           // First never-used block
+    size_t live_ = 0;
+
+    void add_slab();
+};
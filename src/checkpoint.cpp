@@ -0,0 +1,363 @@
+#include "checkpoint.hpp"
+#include "world.hpp"
+#include "brain_pool.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char CHECKPOINT_MAGIC[8] = {'P', 'O', 'L', 'C', 'K', 'P', 'T', '\0'};
+constexpr uint32_t ENDIAN_TAG = 0x01020304;
+constexpr uint64_t SECTION_ALIGN = 64;
+
+static_assert(sizeof(int) == sizeof(int32_t), "int columns are stored as 32-bit");
+
+enum Section : int {
+    SEC_POS_X, SEC_POS_Y, SEC_VEL_X, SEC_VEL_Y, SEC_ENERGY, SEC_FITNESS,
+    SEC_ID, SEC_AGE, SEC_KILLS, SEC_GENERATION,
+    SEC_PREDATOR, SEC_FLAGS, SEC_HAS_BRAIN,
+    SEC_BRAINS,  // brain_count x param_count Reals, in agent order
+    SECTION_COUNT
+};
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_tag;
+    uint64_t file_size;
+    uint64_t agent_count;
+    uint64_t brain_count;
+    uint64_t step_count;
+    uint64_t next_agent_id;
+    uint32_t seed;
+    int32_t generation_counter;
+    int32_t brain_input;
+    int32_t brain_hidden;
+    int32_t brain_output;
+    uint32_t real_size;  // sizeof(Real) of the writer
+    double boundary;
+    uint64_t section_offset[SECTION_COUNT];
+};
+
+const char* precision_name(uint32_t real_size) {
+    return real_size == sizeof(float) ? "float" : "double";
+}
+
+uint64_t align_up(uint64_t offset) {
+    return (offset + SECTION_ALIGN - 1) / SECTION_ALIGN * SECTION_ALIGN;
+}
+
+// Byte size of every section for a given population
+void section_sizes(const CheckpointHeader& h, uint64_t* sizes) {
+    const uint64_t n = h.agent_count;
+    const NetworkShape shape{h.brain_input, h.brain_hidden, h.brain_output};
+    for (int s : {SEC_POS_X, SEC_POS_Y, SEC_VEL_X, SEC_VEL_Y, SEC_ENERGY, SEC_FITNESS}) sizes[s] = n * sizeof(Real);
+    sizes[SEC_ID] = n * sizeof(uint64_t);
+    for (int s : {SEC_AGE, SEC_KILLS, SEC_GENERATION}) sizes[s] = n * sizeof(int32_t);
+    for (int s : {SEC_PREDATOR, SEC_FLAGS, SEC_HAS_BRAIN}) sizes[s] = n * sizeof(uint8_t);
+    sizes[SEC_BRAINS] = h.brain_count * shape.param_count() * sizeof(Real);
+}
+
+// Fill in section offsets and the total size; sections follow the header in order
+void layout(CheckpointHeader& h) {
+    uint64_t sizes[SECTION_COUNT];
+    section_sizes(h, sizes);
+    uint64_t offset = align_up(sizeof(CheckpointHeader));
+    for (int s = 0; s < SECTION_COUNT; ++s) {
+        h.section_offset[s] = offset;
+        offset = align_up(offset + sizes[s]);
+    }
+    h.file_size = offset;
+}
+
+// Read-only memory map of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+#ifdef _WIN32
+        file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) return;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) return;
+        data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (data_) size_ = static_cast<size_t>(size.QuadPart);
+#else
+        fd_ = open(filename.c_str(), O_RDONLY);
+        if (fd_ < 0) return;
+        struct stat st;
+        if (fstat(fd_, &st) != 0 || st.st_size == 0) return;
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (p == MAP_FAILED) return;
+        madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        data_ = static_cast<const uint8_t*>(p);
+        size_ = static_cast<size_t>(st.st_size);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+        if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] const uint8_t* data() const { return data_; }
+    [[nodiscard]] size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+template <class T>
+void copy_section(const uint8_t* base, const CheckpointHeader& h, int section, std::vector<T>& column) {
+    std::memcpy(column.data(), base + h.section_offset[section], column.size() * sizeof(T));
+}
+
+}  // namespace
+
+bool save_checkpoint(const World& world, const std::string& filename) {
+    const AgentStore& agents = world.agents;
+    const SimulationConfig& cfg = *world.config;
+    const NetworkShape shape{cfg.neural_input_size, cfg.neural_hidden_size, cfg.neural_output_size};
+    const size_t n = agents.size();
+
+    std::vector<uint8_t> has_brain(n);
+    uint64_t brain_count = 0;
+    if (!(world.brains->shape() == shape)) {
+        std::cerr << "[Checkpoint] Brain pool does not match the configured network size" << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (agents.brain[i] == NO_BRAIN) continue;
+        has_brain[i] = 1;
+        brain_count++;
+    }
+
+    CheckpointHeader h{};
+    std::memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+    h.version = CHECKPOINT_VERSION;
+    h.endian_tag = ENDIAN_TAG;
+    h.agent_count = n;
+    h.brain_count = brain_count;
+    h.step_count = world.step_count;
+    h.next_agent_id = world.next_agent_id;
+    h.seed = world.seed;
+    h.generation_counter = world.generation_counter;
+    h.brain_input = shape.input;
+    h.brain_hidden = shape.hidden;
+    h.brain_output = shape.output;
+    h.real_size = sizeof(Real);
+    h.boundary = world.boundary;
+    layout(h);
+
+    // Write next to the target and rename, so a crash mid-save leaves the
+    // previous checkpoint intact
+    const std::string tmp = filename + ".tmp";
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "[Checkpoint] Failed to open " << tmp << std::endl;
+        return false;
+    }
+
+    uint64_t written = 0;
+    auto write = [&](const void* data, uint64_t size) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        written += size;
+    };
+    auto pad_to = [&](uint64_t offset) {
+        static const char zeros[SECTION_ALIGN] = {};
+        while (written < offset) write(zeros, std::min<uint64_t>(offset - written, SECTION_ALIGN));
+    };
+    auto column = [&](int section, const auto& values) {
+        pad_to(h.section_offset[section]);
+        write(values.data(), values.size() * sizeof(values[0]));
+    };
+
+    write(&h, sizeof(h));
+    column(SEC_POS_X, agents.pos_x);
+    column(SEC_POS_Y, agents.pos_y);
+    column(SEC_VEL_X, agents.vel_x);
+    column(SEC_VEL_Y, agents.vel_y);
+    column(SEC_ENERGY, agents.energy);
+    column(SEC_FITNESS, agents.fitness);
+    column(SEC_ID, agents.id);
+    column(SEC_AGE, agents.age);
+    column(SEC_KILLS, agents.kills);
+    column(SEC_GENERATION, agents.generation);
+    column(SEC_PREDATOR, agents.predator);
+    column(SEC_FLAGS, agents.flags);
+    column(SEC_HAS_BRAIN, has_brain);
+
+    pad_to(h.section_offset[SEC_BRAINS]);
+    const uint64_t brain_bytes = shape.param_count() * sizeof(Real);
+    for (size_t i = 0; i < n; ++i) {
+        if (has_brain[i]) write(world.brains->params(agents.brain[i]), brain_bytes);
+    }
+
+    pad_to(h.file_size);
+
+    out.close();
+    if (!out) {
+        std::cerr << "[Checkpoint] Failed to write " << tmp << std::endl;
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, filename, ec);
+    if (ec) {
+        std::cerr << "[Checkpoint] Failed to replace " << filename << ": " << ec.message() << std::endl;
+        return false;
+    }
+
+    std::cout << "[Checkpoint] Saved " << n << " agents at step " << world.step_count
+              << " to " << filename << std::endl;
+    return true;
+}
+
+bool load_checkpoint(World& world, const std::string& filename) {
+    MappedFile file(filename);
+    if (!file.data()) {
+        std::cerr << "[Checkpoint] Failed to map " << filename << std::endl;
+        return false;
+    }
+
+    CheckpointHeader h;
+    if (file.size() < sizeof(h)) {
+        std::cerr << "[Checkpoint] " << filename << " is truncated" << std::endl;
+        return false;
+    }
+    std::memcpy(&h, file.data(), sizeof(h));
+
+    if (std::memcmp(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic)) != 0) {
+        std::cerr << "[Checkpoint] " << filename << " is not a checkpoint" << std::endl;
+        return false;
+    }
+    if (h.endian_tag != ENDIAN_TAG) {
+        std::cerr << "[Checkpoint] " << filename << " was written on a machine with different endianness" << std::endl;
+        return false;
+    }
+    if (h.version != CHECKPOINT_VERSION) {
+        std::cerr << "[Checkpoint] Unsupported version " << h.version
+                  << " (expected " << CHECKPOINT_VERSION << ")" << std::endl;
+        return false;
+    }
+    if (h.real_size != sizeof(Real)) {
+        std::cerr << "[Checkpoint] " << filename << " was written by a " << precision_name(h.real_size)
+                  << " build; this build simulates in " << precision_name(sizeof(Real)) << std::endl;
+        return false;
+    }
+
+    // Recompute the layout rather than trusting the stored offsets
+    CheckpointHeader expected = h;
+    layout(expected);
+    if (std::memcmp(expected.section_offset, h.section_offset, sizeof(h.section_offset)) != 0 ||
+        expected.file_size != h.file_size || file.size() < h.file_size) {
+        std::cerr << "[Checkpoint] " << filename << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+
+    const SimulationConfig& cfg = *world.config;
+    const NetworkShape shape{h.brain_input, h.brain_hidden, h.brain_output};
+    if (h.brain_count > 0 &&
+        !(shape == NetworkShape{cfg.neural_input_size, cfg.neural_hidden_size, cfg.neural_output_size})) {
+        std::cerr << "[Checkpoint] Network size " << shape.input << "-" << shape.hidden << "-" << shape.output
+                  << " does not match the configuration" << std::endl;
+        return false;
+    }
+    if (h.boundary != world.boundary) {
+        std::cerr << "[Checkpoint] Warning: checkpoint boundary " << h.boundary
+                  << " differs from the configured " << world.boundary << std::endl;
+    }
+
+    const uint8_t* base = file.data();
+    const size_t n = static_cast<size_t>(h.agent_count);
+    AgentStore& agents = world.agents;
+    agents.clear();
+    agents.resize(n);
+    world.brains->clear();
+
+    copy_section(base, h, SEC_POS_X, agents.pos_x);
+    copy_section(base, h, SEC_POS_Y, agents.pos_y);
+    copy_section(base, h, SEC_VEL_X, agents.vel_x);
+    copy_section(base, h, SEC_VEL_Y, agents.vel_y);
+    copy_section(base, h, SEC_ENERGY, agents.energy);
+    copy_section(base, h, SEC_FITNESS, agents.fitness);
+    copy_section(base, h, SEC_ID, agents.id);
+    copy_section(base, h, SEC_AGE, agents.age);
+    copy_section(base, h, SEC_KILLS, agents.kills);
+    copy_section(base, h, SEC_GENERATION, agents.generation);
+    copy_section(base, h, SEC_PREDATOR, agents.predator);
+    copy_section(base, h, SEC_FLAGS, agents.flags);
+
+    // Brains are packed in agent order; find each agent's block and take a
+    // pool slot for it, then copy the parameters in parallel
+    const uint8_t* has_brain = base + h.section_offset[SEC_HAS_BRAIN];
+    std::vector<uint64_t> brain_slot(n);
+    uint64_t next_slot = 0;
+    for (size_t i = 0; i < n; ++i) {
+        brain_slot[i] = next_slot;
+        if (has_brain[i]) {
+            agents.brain[i] = world.brains->allocate();
+            next_slot++;
+        }
+    }
+    if (next_slot != h.brain_count) {
+        std::cerr << "[Checkpoint] " << filename << " has an inconsistent brain table" << std::endl;
+        agents.clear();
+        world.brains->clear();
+        return false;
+    }
+
+    const Real* brain_params = reinterpret_cast<const Real*>(base + h.section_offset[SEC_BRAINS]);
+    const size_t param_count = shape.param_count();
+    world.pool->parallel_for(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (has_brain[i]) {
+                std::memcpy(world.brains->params(agents.brain[i]), brain_params + brain_slot[i] * param_count,
+                            param_count * sizeof(Real));
+            }
+        }
+    }, 4096);
+
+    world.seed = h.seed;
+    world.next_agent_id = h.next_agent_id;
+    world.step_count = h.step_count;
+    world.generation_counter = h.generation_counter;
+    world.population.recount(agents, world.step_count);
+
+    std::cout << "[Checkpoint] Restored " << n << " agents at step " << world.step_count
+              << " from " << filename << std::endl;
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+struct World;
+
+/**
+ * @brief Binary world checkpoints.
+ *
+ * A checkpoint is one file: a fixed header followed by 64-byte aligned
+ * sections holding each agent column as a raw array and the parameter blocks
+ * of all brains packed back to back in agent order. The header carries the
+ * step, seed and next agent id, which with the agent ids is all the random
+ * state there is (see CounterRng).
+ * Saving streams the sections out in order (via a temporary file that is
+ * renamed into place, so an interrupted save never clobbers the previous
+ * checkpoint). Loading maps the file into memory and copies the sections
+ * straight into the agent columns.
+ *
+ * Files are only read back on machines with the same endianness, and by
+ * builds with the same Real (see POLARIS_FLOAT). Trails (visual only) are
+ * not saved. The SimulationConfig is not saved either: load
+ * a checkpoint into a world built from the config the run used.
+ *
+ * Example usage:
+ *
+ * save_checkpoint(world, "run.ckpt");
+ * ...
+ * World world(config, config.seed);
+ * load_checkpoint(world, "run.ckpt");
+ */
+
+constexpr uint32_t CHECKPOINT_VERSION = 2;
+
+bool save_checkpoint(const World& world, const std::string& filename);
+
+// Replace the world's population, step counter, seed and next agent id with
+// the checkpoint's. Brain sizes must match the world's configuration.
+bool load_checkpoint(World& world, const std::string& filename);
@@ -1,19 +1,29 @@
 #include "config.hpp"
 #include "../external/json.hpp"
 #include <fstream>
+#include <sstream>
 #include <iostream>
 
 using json = nlohmann::json;
 
 bool SimulationConfig::load_from_file(const std::string& filename) {
-    try {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "[Config] Failed to open file: " << filename << std::endl;
-            return false;
-        }
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "[Config] Failed to open file: " << filename << std::endl;
+        return false;
+    }
+
+    std::stringstream text;
+    text << file.rdbuf();
+    if (!load_from_json(text.str())) return false;
 
-        json j = json::parse(file);
+    std::cout << "[Config] Loaded from " << filename << std::endl;
+    return true;
+}
+
+bool SimulationConfig::load_from_json(const std::string& text) {
+    try {
+        json j = json::parse(text);
 
         // Load all parameters with validation
         if (j.contains("num_agents")) num_agents = j["num_agents"];
@@ -21,6 +31,8 @@ bool SimulationConfig::load_from_file(const std::string& filename) {
         if (j.contains("max_steps")) max_steps = j["max_steps"];
         if (j.contains("seed")) seed = j["seed"];
         if (j.contains("boundary")) boundary = j["boundary"];
+        if (j.contains("wrap_world")) wrap_world = j["wrap_world"];
+        if (j.contains("num_threads")) num_threads = j["num_threads"];
         
         if (j.contains("predator_chance")) predator_chance = j["predator_chance"];
         if (j.contains("initial_energy")) initial_energy = j["initial_energy"];
@@ -46,17 +58,28 @@ bool SimulationConfig::load_from_file(const std::string& filename) {
         if (j.contains("eating_range")) eating_range = j["eating_range"];
         
         if (j.contains("grid_cells")) grid_cells = j["grid_cells"];
+        if (j.contains("incremental_grid")) incremental_grid = j["incremental_grid"];
         if (j.contains("window_width")) window_width = j["window_width"];
         if (j.contains("window_height")) window_height = j["window_height"];
         if (j.contains("render_fps")) render_fps = j["render_fps"];
         if (j.contains("show_trails")) show_trails = j["show_trails"];
         if (j.contains("trail_length")) trail_length = j["trail_length"];
+        if (j.contains("heatmap_threshold")) heatmap_threshold = j["heatmap_threshold"];
         
         if (j.contains("enable_stats")) enable_stats = j["enable_stats"];
         if (j.contains("stats_interval")) stats_interval = j["stats_interval"];
         if (j.contains("stats_output_file")) stats_output_file = j["stats_output_file"];
+        if (j.contains("stats_format")) stats_format = j["stats_format"];
+        if (j.contains("stats_flush_rows")) stats_flush_rows = j["stats_flush_rows"];
+        if (j.contains("stats_flush_seconds")) stats_flush_seconds = j["stats_flush_seconds"];
+        if (j.contains("stats_history_length")) stats_history_length = j["stats_history_length"];
+
+        if (j.contains("enable_profiling")) enable_profiling = j["enable_profiling"];
+        if (j.contains("trace_output_file")) trace_output_file = j["trace_output_file"];
+
+        if (j.contains("replay_output_file")) replay_output_file = j["replay_output_file"];
+        if (j.contains("keyframe_interval")) keyframe_interval = j["keyframe_interval"];
 
-        std::cout << "[Config] Loaded from " << filename << std::endl;
         return true;
     }
     catch (const json::parse_error& e) {
@@ -71,49 +94,13 @@ bool SimulationConfig::load_from_file(const std::string& filename) {
 
 bool SimulationConfig::save_to_file(const std::string& filename) const {
     try {
-        json j;
-        
-        j["num_agents"] = num_agents;
-        j["dt"] = dt;
-        j["max_steps"] = max_steps;
-        j["seed"] = seed;
-        j["boundary"] = boundary;
-        j["predator_chance"] = predator_chance;
-        j["initial_energy"] = initial_energy;
-        j["max_energy"] = max_energy;
-        j["energy_consumption_rate"] = energy_consumption_rate;
-        j["energy_gain_from_prey"] = energy_gain_from_prey;
-        j["reproduction_energy_threshold"] = reproduction_energy_threshold;
-        j["reproduction_energy_cost"] = reproduction_energy_cost;
-        j["enable_ai"] = enable_ai;
-        j["neural_input_size"] = neural_input_size;
-        j["neural_hidden_size"] = neural_hidden_size;
-        j["neural_output_size"] = neural_output_size;
-        j["mutation_rate"] = mutation_rate;
-        j["mutation_strength"] = mutation_strength;
-        j["predator_chase_strength"] = predator_chase_strength;
-        j["prey_flee_strength"] = prey_flee_strength;
-        j["separation_strength"] = separation_strength;
-        j["interaction_range"] = interaction_range;
-        j["separation_range"] = separation_range;
-        j["eating_range"] = eating_range;
-        j["grid_cells"] = grid_cells;
-        j["window_width"] = window_width;
-        j["window_height"] = window_height;
-        j["render_fps"] = render_fps;
-        j["show_trails"] = show_trails;
-        j["trail_length"] = trail_length;
-        j["enable_stats"] = enable_stats;
-        j["stats_interval"] = stats_interval;
-        j["stats_output_file"] = stats_output_file;
-
         std::ofstream file(filename);
         if (!file.is_open()) {
             std::cerr << "[Config] Failed to create file: " << filename << std::endl;
             return false;
         }
 
-        file << j.dump(2) << std::endl;  // Pretty print with 2-space indent
+        file << to_json() << std::endl;
         std::cout << "[Config] Saved to " << filename << std::endl;
         return true;
     }
@@ -123,6 +110,60 @@ bool SimulationConfig::save_to_file(const std::string& filename) const {
     }
 }
 
+std::string SimulationConfig::to_json() const {
+    json j;
+    
+    j["num_agents"] = num_agents;
+    j["dt"] = dt;
+    j["max_steps"] = max_steps;
+    j["seed"] = seed;
+    j["boundary"] = boundary;
+    j["wrap_world"] = wrap_world;
+    j["num_threads"] = num_threads;
+    j["predator_chance"] = predator_chance;
+    j["initial_energy"] = initial_energy;
+    j["max_energy"] = max_energy;
+    j["energy_consumption_rate"] = energy_consumption_rate;
+    j["energy_gain_from_prey"] = energy_gain_from_prey;
+    j["reproduction_energy_threshold"] = reproduction_energy_threshold;
+    j["reproduction_energy_cost"] = reproduction_energy_cost;
+    j["enable_ai"] = enable_ai;
+    j["neural_input_size"] = neural_input_size;
+    j["neural_hidden_size"] = neural_hidden_size;
+    j["neural_output_size"] = neural_output_size;
+    j["mutation_rate"] = mutation_rate;
+    j["mutation_strength"] = mutation_strength;
+    j["predator_chase_strength"] = predator_chase_strength;
+    j["prey_flee_strength"] = prey_flee_strength;
+    j["separation_strength"] = separation_strength;
+    j["interaction_range"] = interaction_range;
+    j["separation_range"] = separation_range;
+    j["eating_range"] = eating_range;
+    j["grid_cells"] = grid_cells;
+    j["incremental_grid"] = incremental_grid;
+    j["window_width"] = window_width;
+    j["window_height"] = window_height;
+    j["render_fps"] = render_fps;
+    j["show_trails"] = show_trails;
+    j["trail_length"] = trail_length;
+    j["heatmap_threshold"] = heatmap_threshold;
+    j["enable_stats"] = enable_stats;
+    j["stats_interval"] = stats_interval;
+    j["stats_output_file"] = stats_output_file;
+    j["stats_format"] = stats_format;
+    j["stats_flush_rows"] = stats_flush_rows;
+    j["stats_flush_seconds"] = stats_flush_seconds;
+    j["stats_history_length"] = stats_history_length;
+
+    j["enable_profiling"] = enable_profiling;
+    j["trace_output_file"] = trace_output_file;
+
+    j["replay_output_file"] = replay_output_file;
+    j["keyframe_interval"] = keyframe_interval;
+
+    return j.dump(2);  // Pretty print with 2-space indent
+}
+
 SimulationConfig SimulationConfig::create_default() {
     return SimulationConfig{};
 }
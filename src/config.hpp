@@ -8,6 +8,8 @@ struct SimulationConfig {
     int max_steps = 2000;
     unsigned seed = 42;
     double boundary = 6.0;
+    bool wrap_world = false;  // Toroidal world: agents leaving one edge re-enter at the opposite one instead of bouncing
+    int num_threads = 0;  // Worker threads for World::update (0 = all hardware threads)
 
     // Agent parameters (rebalanced)
     double predator_chance = 0.25;
@@ -36,6 +38,7 @@ struct SimulationConfig {
 
     // Spatial partitioning
     int grid_cells = 20;
+    bool incremental_grid = true;  // Only move agents that changed cell (falls back to a rebuild under churn)
 
     // Visualization
     int window_width = 800;
@@ -43,11 +46,24 @@ struct SimulationConfig {
     int render_fps = 60;
     bool show_trails = false;
     int trail_length = 20;
+    int heatmap_threshold = 50000;  // Agents in view above which the window draws a density heatmap (0 = never)
 
     // Statistics
     bool enable_stats = true;
     int stats_interval = 100;
     std::string stats_output_file = "stats.csv";
+    std::string stats_format = "csv";  // "csv" or "binary" (columnar; polaris_headless --stats-to-csv converts it)
+    int stats_flush_rows = 256;        // Snapshots the writer thread batches before writing them out
+    double stats_flush_seconds = 1.0;  // ...or the longest a snapshot waits to be written (0 = full batches only)
+    int stats_history_length = 1000;   // Snapshots kept in memory for the statistics panel
+
+    // Profiling
+    bool enable_profiling = false;  // Per-phase timing summary at the end of a run
+    std::string trace_output_file = "";  // Chrome trace of the profiled phases (empty = off)
+
+    // Replay
+    std::string replay_output_file = "";  // Record a replay log of the run (empty = off)
+    int keyframe_interval = 10000;  // Steps between replay keyframes
 
     // Load from JSON file
     bool load_from_file(const std::string& filename);
@@ -55,6 +71,10 @@ struct SimulationConfig {
     // Save to JSON file
     bool save_to_file(const std::string& filename) const;
 
+    // Same as the file variants, on JSON text (unknown keys are ignored)
+    bool load_from_json(const std::string& text);
+    std::string to_json() const;
+
     // Create default config
     static SimulationConfig create_default();
 };
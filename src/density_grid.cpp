@@ -0,0 +1,102 @@
+#include "density_grid.hpp"
+#include "render_snapshot.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void DensityGrid::accumulate(const RenderSnapshot& frame, double min_x, double min_y, double cell_size,
+                             int cols, int rows, ThreadPool& pool) {
+    cols_ = std::max(cols, 0);
+    rows_ = std::max(rows, 0);
+    const size_t num_cells = static_cast<size_t>(cols_) * rows_;
+    const size_t n = frame.size();
+
+    // Few agents are not worth waking the pool for
+    const size_t slices = n < 16384 ? 1 : static_cast<size_t>(pool.size());
+    cells_.resize(num_cells);
+    partial_.resize(slices * num_cells);
+    slice_totals_.assign(slices, 0);
+
+    const float x0 = static_cast<float>(min_x);
+    const float y0 = static_cast<float>(min_y);
+    const float inv_cell = static_cast<float>(1.0 / cell_size);
+    const float fcols = static_cast<float>(cols_);
+    const float frows = static_cast<float>(rows_);
+
+    pool.parallel_for(slices, [&](size_t s_begin, size_t s_end) {
+        for (size_t s = s_begin; s < s_end; ++s) {
+            Cell* grid = partial_.data() + s * num_cells;
+            std::memset(grid, 0, num_cells * sizeof(Cell));
+
+            size_t inside = 0;
+            for (size_t i = n * s / slices; i < n * (s + 1) / slices; ++i) {
+                const float gx = (frame.x[i] - x0) * inv_cell;
+                const float gy = (frame.y[i] - y0) * inv_cell;
+                if (!(gx >= 0.0f && gx < fcols && gy >= 0.0f && gy < frows)) continue;  // Also drops NaN
+
+                const int col = std::min(static_cast<int>(gx), cols_ - 1);
+                const int row = std::min(static_cast<int>(gy), rows_ - 1);
+                Cell& c = grid[static_cast<size_t>(row) * cols_ + col];
+                const int species = frame.predator[i] ? PREDATOR : PREY;
+                c.count[species]++;
+                c.energy[species] += frame.energy[i];
+                inside++;
+            }
+            slice_totals_[s] = inside;
+        }
+    }, 1);
+
+    // Sum the slices cell by cell
+    pool.parallel_for(num_cells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            Cell sum = partial_[c];
+            for (size_t s = 1; s < slices; ++s) {
+                const Cell& p = partial_[s * num_cells + c];
+                for (int k = 0; k < 2; ++k) {
+                    sum.count[k] += p.count[k];
+                    sum.energy[k] += p.energy[k];
+                }
+            }
+            cells_[c] = sum;
+        }
+    }, 4096);
+
+    total_ = 0;
+    for (size_t t : slice_totals_) total_ += t;
+}
+
+void DensityGrid::colorize(uint8_t* pixels, int pitch) const {
+    uint32_t max_count = 0;
+    for (const Cell& c : cells_) max_count = std::max({max_count, c.count[PREY], c.count[PREDATOR]});
+    const float inv_log_max = max_count > 0 ? 1.0f / std::log1p(static_cast<float>(max_count)) : 0.0f;
+
+    for (int row = 0; row < rows_; ++row) {
+        uint8_t* out = pixels + static_cast<ptrdiff_t>(row) * pitch;
+        for (int col = 0; col < cols_; ++col, out += 4) {
+            const Cell& c = cell(col, row);
+            float r = 0.0f, g = 0.0f, b = 0.0f;
+
+            // Same colors as the per-agent sprites at the cell's mean energy
+            if (c.count[PREY] > 0) {
+                const float w = std::log1p(static_cast<float>(c.count[PREY])) * inv_log_max;
+                const float energy = c.energy[PREY] / static_cast<float>(c.count[PREY]);
+                r += w * 50.0f;
+                g += w * (50.0f + std::clamp(energy * 1.5f, 0.0f, 205.0f));
+                b += w * 255.0f;
+            }
+            if (c.count[PREDATOR] > 0) {
+                const float w = std::log1p(static_cast<float>(c.count[PREDATOR])) * inv_log_max;
+                const float energy = c.energy[PREDATOR] / static_cast<float>(c.count[PREDATOR]);
+                r += w * (50.0f + std::clamp(energy * 2.0f, 0.0f, 205.0f));
+                g += w * 50.0f;
+                b += w * 50.0f;
+            }
+
+            out[0] = static_cast<uint8_t>(std::min(r, 255.0f));
+            out[1] = static_cast<uint8_t>(std::min(g, 255.0f));
+            out[2] = static_cast<uint8_t>(std::min(b, 255.0f));
+            out[3] = 255;
+        }
+    }
+}
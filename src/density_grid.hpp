@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct RenderSnapshot;
+class ThreadPool;
+
+/**
+ * @brief Per-species agent counts and mean energy binned over a rectangle of the world.
+ *
+ * The window's level-of-detail path for large populations: instead of one
+ * sprite per agent it bins the snapshot into a grid of a few hundred cells
+ * per side and draws that as one texture. Binning is split into one slice of
+ * agents per pool thread, each counted into its own partial grid, and the
+ * partial grids are then summed cell by cell, so no two threads ever write
+ * the same cell. Agents outside the rectangle are skipped; total() is the
+ * number that landed in the grid. Buffers are kept between frames.
+ *
+ * Example usage:
+ *
+ * DensityGrid grid;
+ * grid.accumulate(frame, -boundary, -boundary, 2 * boundary / 200, 200, 200, pool);
+ * grid.colorize(pixels, pitch);
+ */
+class DensityGrid {
+public:
+    static constexpr int PREY = 0;
+    static constexpr int PREDATOR = 1;
+
+    struct Cell {
+        uint32_t count[2];  // Agents per species
+        float energy[2];    // Summed energy per species
+    };
+
+    // Bin frame into cols x rows cells of cell_size world units, the first
+    // one starting at (min_x, min_y)
+    void accumulate(const RenderSnapshot& frame, double min_x, double min_y, double cell_size,
+                    int cols, int rows, ThreadPool& pool);
+
+    // Write the grid as RGBA8 pixels, one per cell: prey blue and predators
+    // red, brighter with more energy, and log-scaled by density so sparse
+    // regions stay visible next to dense ones. pitch is bytes per row.
+    void colorize(uint8_t* pixels, int pitch) const;
+
+    [[nodiscard]] int cols() const { return cols_; }
+    [[nodiscard]] int rows() const { return rows_; }
+    [[nodiscard]] const Cell& cell(int col, int row) const { return cells_[static_cast<size_t>(row) * cols_ + col]; }
+    [[nodiscard]] size_t total() const { return total_; }
+
+private:
+    int cols_ = 0;
+    int rows_ = 0;
+    size_t total_ = 0;
+    std::vector<Cell> cells_;
+    std::vector<Cell> partial_;          // One grid per slice, back to back
+    std::vector<size_t> slice_totals_;
+};
@@ -0,0 +1,46 @@
+#include "fixed_network.hpp"
+#include <vector>
+
+namespace {
+
+struct RegisteredNetwork {
+    NetworkShape shape;
+    NetworkBatchKernel kernel;
+};
+
+template <int In, int Hidden, int Out>
+constexpr RegisteredNetwork fixed() {
+    return {FixedNetwork<In, Hidden, Out>::shape, &FixedNetwork<In, Hidden, Out>::forward_rows};
+}
+
+// Shapes with a specialized kernel: the default brain, a wider hidden layer,
+// and a larger sensor/actuator set
+constexpr RegisteredNetwork FIXED_NETWORKS[] = {
+    fixed<8, 12, 2>(),
+    fixed<8, 16, 2>(),
+    fixed<16, 32, 4>(),
+};
+
+}  // namespace
+
+void network_forward_rows(const NetworkShape& shape, const Real* const* params,
+                          const Real* inputs, Real* outputs, size_t begin, size_t end) {
+    std::vector<Real> hidden(shape.hidden);
+    for (size_t row = begin; row < end; ++row) {
+        if (!params[row]) continue;
+        network_forward(shape, params[row], inputs + row * shape.input,
+                        outputs + row * shape.output, hidden.data());
+    }
+}
+
+NetworkBatchKernel find_fixed_network_kernel(const NetworkShape& shape) {
+    for (const RegisteredNetwork& n : FIXED_NETWORKS) {
+        if (n.shape == shape) return n.kernel;
+    }
+    return nullptr;
+}
+
+NetworkBatchKernel select_network_kernel(const NetworkShape& shape) {
+    const NetworkBatchKernel kernel = find_fixed_network_kernel(shape);
+    return kernel ? kernel : &network_forward_rows;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <utility>
+#include "neural_network.hpp"
+#include "simd.hpp"
+
+// Evaluate rows [begin, end) of a batch: row r reads the parameter block
+// params[r] (skipped when null) and inputs + r * shape.input, and writes
+// outputs + r * shape.output
+using NetworkBatchKernel = void (*)(const NetworkShape& shape, const Real* const* params,
+                                    const Real* inputs, Real* outputs, size_t begin, size_t end);
+
+// Kernel of the registered FixedNetwork for shape, or nullptr if none is
+NetworkBatchKernel find_fixed_network_kernel(const NetworkShape& shape);
+
+// find_fixed_network_kernel(), falling back to a network_forward() loop
+NetworkBatchKernel select_network_kernel(const NetworkShape& shape);
+
+// The generic fallback, for any shape
+void network_forward_rows(const NetworkShape& shape, const Real* const* params,
+                          const Real* inputs, Real* outputs, size_t begin, size_t end);
+
+// Call f(std::integral_constant<int, 0>) ... f(std::integral_constant<int, N - 1>)
+template <int N, class F>
+inline void unrolled(F&& f) {
+    [&]<int... I>(std::integer_sequence<int, I...>) {
+        (f(std::integral_constant<int, I>{}), ...);
+    }(std::make_integer_sequence<int, N>{});
+}
+
+// dense_tanh() from neural_network.cpp with the sizes known at compile time:
+// every loop is unrolled and the accumulators for all outputs stay in
+// registers across the inputs. Each output sums its inputs in the same order,
+// so results are bit-identical to network_forward().
+template <int NIn, int NOut>
+inline void fixed_dense_tanh(const Real* in, const Real* weights, const Real* bias, Real* out) {
+    constexpr int full = NOut / VecR::width;
+    constexpr int rest = NOut % VecR::width;
+
+    VecR acc[full + 1];
+    unrolled<full>([&](auto v) { acc[v] = VecR::load(bias + v * VecR::width); });
+    if constexpr (rest > 0) acc[full] = VecR::load_partial(bias + full * VecR::width, rest);
+
+    unrolled<NIn>([&](auto i) {
+        const VecR x = VecR::broadcast(in[i]);
+        const Real* row = weights + i * NOut;
+        unrolled<full>([&](auto v) { acc[v] = fmadd(x, VecR::load(row + v * VecR::width), acc[v]); });
+        if constexpr (rest > 0) {
+            acc[full] = fmadd(x, VecR::load_partial(row + full * VecR::width, rest), acc[full]);
+        }
+    });
+
+    unrolled<full>([&](auto v) { tanh_approx(acc[v]).store(out + v * VecR::width); });
+    if constexpr (rest > 0) tanh_approx(acc[full]).store_partial(out + full * VecR::width, rest);
+}
+
+/**
+ * @brief A network whose layer sizes are template parameters.
+ *
+ * Same packed parameter layout as network_forward(), so a FixedNetwork can
+ * evaluate blocks from a BrainPool or a NeuralNetwork unchanged; only the loop
+ * bounds differ. With the sizes known the compiler unrolls both layers, keeps
+ * the hidden layer in registers and drops the remainder handling that a
+ * runtime size needs, which is most of the work for a brain as small as the
+ * default 8-12-2.
+ *
+ * Shapes that World should dispatch to are listed in fixed_network.cpp;
+ * select_network_kernel() picks one by shape and falls back to the generic
+ * kernel for everything else.
+ *
+ * Example usage:
+ *
+ * FixedNetwork<8, 12, 2> net;
+ * network_init(net.shape, net.params.data(), rng);
+ * net.forward(inputs, outputs);
+ * NetworkBatchKernel kernel = select_network_kernel(config_shape);
+ */
+template <int In, int Hidden, int Out>
+struct FixedNetwork {
+    static constexpr NetworkShape shape{In, Hidden, Out};
+    static constexpr size_t PARAM_COUNT = static_cast<size_t>(In) * Hidden + Hidden +
+                                          static_cast<size_t>(Hidden) * Out + Out;
+
+    std::array<Real, PARAM_COUNT> params{};
+
+    static void forward(const Real* params, const Real* inputs, Real* outputs) {
+        const Real* w_ih = params;
+        const Real* b_h = w_ih + In * Hidden;
+        const Real* w_ho = b_h + Hidden;
+        const Real* b_o = w_ho + Hidden * Out;
+
+        alignas(64) Real hidden[Hidden];
+        fixed_dense_tanh<In, Hidden>(inputs, w_ih, b_h, hidden);
+        fixed_dense_tanh<Hidden, Out>(hidden, w_ho, b_o, outputs);
+    }
+
+    void forward(const Real* inputs, Real* outputs) const { forward(params.data(), inputs, outputs); }
+
+    // A NetworkBatchKernel for this shape
+    static void forward_rows(const NetworkShape&, const Real* const* params,
+                             const Real* inputs, Real* outputs, size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+            if (!params[row]) continue;
+            forward(params[row], inputs + row * In, outputs + row * Out);
+        }
+    }
+};
@@ -0,0 +1,229 @@
+// Headless entry point: runs the simulation as fast as possible with no
+// window, GUI or frame cap. Intended for batch runs and parameter sweeps.
+#include "scheduler.hpp"
+#include "world.hpp"
+#include "config.hpp"
+#include "statistics.hpp"
+#include "checkpoint.hpp"
+#include "replay.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+void print_usage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [config.json] [options]\n"
+              << "\n"
+              << "Options:\n"
+              << "  --steps N           Number of steps to run (overrides max_steps)\n"
+              << "  --seed N            World seed\n"
+              << "  --agents N          Initial population (overrides num_agents)\n"
+              << "  --threads N         Worker threads (0 = all cores)\n"
+              << "  --wrap              Toroidal world: agents wrap around the edges (sets wrap_world)\n"
+              << "  --stats FILE        Statistics output file\n"
+              << "  --stats-interval N  Steps between statistics snapshots\n"
+              << "  --no-stats          Disable statistics logging\n"
+              << "  --stats-format F    csv or binary (columnar, full precision, cheaper to write)\n"
+              << "  --stats-to-csv IN OUT  Convert a binary statistics file to CSV and exit\n"
+              << "  --save-config FILE  Write the effective configuration to FILE\n"
+              << "  --resume FILE       Continue from a checkpoint\n"
+              << "  --checkpoint FILE   Save a checkpoint at the end of the run\n"
+              << "  --checkpoint-interval N  Also save every N steps\n"
+              << "  --record FILE       Record a replay log (keyframes are written next to it)\n"
+              << "  --keyframe-interval N  Steps between replay keyframes\n"
+              << "  --replay FILE --to N  Re-simulate a recorded run up to step N and stop\n"
+              << "  --profile           Print per-phase timings at the end\n"
+              << "  --trace FILE        Also write a Chrome trace of the phases (implies --profile)\n"
+              << "  --quiet             Only print the final summary\n"
+              << "  -h, --help          Show this message\n";
+}
+
+// Parse an integer option value, exiting with a message on malformed input
+long parse_int(const std::string& option, const char* value) {
+    char* end = nullptr;
+    long parsed = std::strtol(value, &end, 10);
+    if (end == value || *end != '\0') {
+        std::cerr << "[Headless] Invalid value for " << option << ": " << value << "\n";
+        std::exit(2);
+    }
+    return parsed;
+}
+
+// Re-simulate a recorded run to target_step, then optionally checkpoint it
+int run_replay(const std::string& replay_path, uint64_t target_step, int num_threads,
+               const std::string& checkpoint_path) {
+    ReplayPlayer player(replay_path);
+    if (!player.is_open()) return 1;
+
+    // Thread count never changes results, so it may differ from the recording
+    SimulationConfig config = player.initial_config();
+    config.num_threads = num_threads;
+    World world(config, player.seed());
+
+    auto start = std::chrono::steady_clock::now();
+    if (!player.seek(world, config, target_step)) return 1;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[Headless] Replayed to step " << world.step_count << " in " << seconds << " s\n";
+    std::cout << "[Headless] Population: " << world.agents.size()
+              << " (" << world.count_predators() << " predators, "
+              << world.count_prey() << " prey)\n";
+    if (!checkpoint_path.empty() && !save_checkpoint(world, checkpoint_path)) return 1;
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    SimulationConfig config = SimulationConfig::create_default();
+    std::string save_config_path;
+    std::string resume_path;
+    std::string checkpoint_path;
+    int checkpoint_interval = 0;
+    std::string replay_path;
+    long long replay_target = -1;
+    std::string stats_convert_input;
+    std::string stats_convert_output;
+    bool quiet = false;
+
+    // The config file is applied first so command-line overrides win
+    int first_option = 1;
+    if (argc > 1 && argv[1][0] != '-') {
+        if (!config.load_from_file(argv[1])) {
+            std::cerr << "[Headless] Could not load " << argv[1] << "\n";
+            return 1;
+        }
+        first_option = 2;
+    }
+
+    for (int i = first_option; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "[Headless] Missing value for " << arg << "\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-h" || arg == "--help") { print_usage(argv[0]); return 0; }
+        else if (arg == "--steps") config.max_steps = static_cast<int>(parse_int(arg, value()));
+        else if (arg == "--seed") config.seed = static_cast<unsigned>(parse_int(arg, value()));
+        else if (arg == "--agents") config.num_agents = static_cast<int>(parse_int(arg, value()));
+        else if (arg == "--threads") config.num_threads = static_cast<int>(parse_int(arg, value()));
+        else if (arg == "--wrap") config.wrap_world = true;
+        else if (arg == "--stats") config.stats_output_file = value();
+        else if (arg == "--stats-interval") config.stats_interval = static_cast<int>(parse_int(arg, value()));
+        else if (arg == "--no-stats") config.enable_stats = false;
+        else if (arg == "--stats-format") config.stats_format = value();
+        else if (arg == "--stats-to-csv") { stats_convert_input = value(); stats_convert_output = value(); }
+        else if (arg == "--save-config") save_config_path = value();
+        else if (arg == "--resume") resume_path = value();
+        else if (arg == "--checkpoint") checkpoint_path = value();
+        else if (arg == "--checkpoint-interval") checkpoint_interval = static_cast<int>(parse_int(arg, value()));
+        else if (arg == "--record") config.replay_output_file = value();
+        else if (arg == "--keyframe-interval") config.keyframe_interval = static_cast<int>(parse_int(arg, value()));
+        else if (arg == "--replay") replay_path = value();
+        else if (arg == "--to") replay_target = parse_int(arg, value());
+        else if (arg == "--profile") config.enable_profiling = true;
+        else if (arg == "--trace") { config.trace_output_file = value(); config.enable_profiling = true; }
+        else if (arg == "--quiet") quiet = true;
+        else {
+            std::cerr << "[Headless] Unknown option: " << arg << "\n";
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (!stats_convert_input.empty()) {
+        return convert_stats_to_csv(stats_convert_input, stats_convert_output) ? 0 : 1;
+    }
+
+    if (!replay_path.empty()) {
+        if (replay_target < 0) {
+            std::cerr << "[Headless] --replay needs --to STEP\n";
+            return 2;
+        }
+        return run_replay(replay_path, static_cast<uint64_t>(replay_target), config.num_threads, checkpoint_path);
+    }
+
+    if (config.stats_interval <= 0) config.stats_interval = 1;
+    if (!save_config_path.empty()) config.save_to_file(save_config_path);
+
+    World world(config, config.seed);
+    if (!resume_path.empty() && !load_checkpoint(world, resume_path)) return 1;
+
+    std::unique_ptr<ReplayRecorder> recorder;
+    if (!config.replay_output_file.empty()) {
+        recorder = std::make_unique<ReplayRecorder>(config.replay_output_file, config, world.seed,
+                                                    config.keyframe_interval);
+        world.set_recorder(recorder.get());
+    }
+    Statistics stats(config.stats_output_file, config.enable_stats, StatsOptions::from_config(config));
+    world.set_statistics(&stats);
+
+    Scheduler scheduler(config.dt, config.max_steps, config.seed);
+    scheduler.enable_profiling(config.enable_profiling);
+    scheduler.set_trace_file(config.trace_output_file);
+    world.set_profiler(&scheduler.profiler());
+
+    // Sum of live agents over all steps, for agent-steps/sec
+    double agent_steps = 0.0;
+    int steps_run = 0;
+
+    scheduler.set_on_start([&]() {
+        std::cout << "[Headless] " << config.max_steps << " steps, "
+                  << world.agents.size() << " agents ("
+                  << world.count_predators() << " predators, "
+                  << world.count_prey() << " prey)\n";
+    });
+
+    scheduler.set_on_step([&](int loop_step, double dt) {
+        steps_run = loop_step + 1;
+
+        // Number rows by the world's own step, so a resumed run carries on
+        // from its checkpoint instead of starting again at 0
+        const int step = static_cast<int>(world.step_count - 1);
+        if (step % config.stats_interval == 0) {
+            ScopedPhase scope(&scheduler.profiler(), Phase::Stats);
+            if (!quiet) {
+                std::cout << "[Tick " << step << "] Population: " << world.agents.size()
+                          << " (P:" << world.count_predators()
+                          << " Y:" << world.count_prey() << ")" << std::endl;
+            }
+            stats.record_step(step, step * dt, world);
+        }
+
+        if (checkpoint_interval > 0 && !checkpoint_path.empty() &&
+            world.step_count % checkpoint_interval == 0) {
+            save_checkpoint(world, checkpoint_path);
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    scheduler.run([&](double dt, int) {
+        agent_steps += static_cast<double>(world.agents.size());
+        if (recorder) recorder->before_step(world);
+        world.update(dt);
+        if (recorder) recorder->after_step(world);
+    });
+    auto end = std::chrono::steady_clock::now();
+    stats.flush();
+    if (!checkpoint_path.empty() && !save_checkpoint(world, checkpoint_path)) return 1;
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    const double safe_seconds = seconds > 0.0 ? seconds : 1e-9;
+
+    std::cout << "[Headless] Finished " << steps_run << " steps in " << seconds << " s\n";
+    std::cout << "[Headless] Final population: " << world.agents.size()
+              << " (" << world.count_predators() << " predators, "
+              << world.count_prey() << " prey)\n";
+    std::cout << "[Headless] Total births: " << stats.total_births()
+              << ", total deaths: " << stats.total_deaths() << "\n";
+    std::cout << "[Headless] Steps/sec: " << steps_run / safe_seconds << "\n";
+    std::cout << "[Headless] Agent-steps/sec: " << agent_steps / safe_seconds << "\n";
+    return 0;
+}
@@ -1,9 +1,8 @@
 #include "imgui_panel.hpp"
-#include "statistics.hpp"
-#include "world.hpp"
 #include "../external/imgui.h"
 #include "../external/imgui_impl_sdl2.h"
 #include "../external/imgui_impl_sdlrenderer2.h"
+#include <algorithm>
 #include <iostream>
 
 ImGuiPanel::ImGuiPanel() {}
@@ -90,20 +89,25 @@ void ImGuiPanel::begin_frame() {
     ImGui::NewFrame();
 }
 
-void ImGuiPanel::render(SimulationConfig& config, const Statistics* stats, World* world) {
+void ImGuiPanel::render(SimulationConfig& config, const RenderSnapshot& frame, SimCommandQueue& commands) {
     if (!initialized_) return;
 
     if (show_config_window_) {
-        render_config_panel(config, world);
+        render_config_panel(config, commands);
     }
 
-    if (show_stats_window_ && stats) {
-        render_stats_panel(stats);
+    if (show_stats_window_) {
+        render_stats_panel(frame);
     }
 }
 
-void ImGuiPanel::render_config_panel(SimulationConfig& config, World* world) {
+static void send(SimCommandQueue& commands, const SimCommand& command) {
+    if (!commands.try_push(command)) std::cout << "[UI] Simulation busy, request dropped\n";
+}
+
+void ImGuiPanel::render_config_panel(SimulationConfig& config, SimCommandQueue& commands) {
     ImGui::Begin("Simulation Config", &show_config_window_);
+    bool changed = false;
     
     ImGui::Text("Controls: [SPACE] Pause | [ESC] Quit");
     ImGui::Text("[G] Toggle UI | [C] Config | [S] Stats | [T] Trails");
@@ -112,6 +116,7 @@ void ImGuiPanel::render_config_panel(SimulationConfig& config, World* world) {
     // AI Toggle
     ImGui::Text("AI System");
     if (ImGui::Checkbox("Enable AI Control", &config.enable_ai)) {
+        changed = true;
         std::cout << (config.enable_ai ? "[AI] Enabled - Agents now use neural networks\n" : "[AI] Disabled - Using scripted behavior\n");
     }
     
@@ -120,10 +125,12 @@ void ImGuiPanel::render_config_panel(SimulationConfig& config, World* world) {
         float mut_rate = static_cast<float>(config.mutation_rate);
         if (ImGui::SliderFloat("Mutation Rate", &mut_rate, 0.0f, 0.5f)) {
             config.mutation_rate = mut_rate;
+            changed = true;
         }
         float mut_str = static_cast<float>(config.mutation_strength);
         if (ImGui::SliderFloat("Mutation Strength", &mut_str, 0.0f, 1.0f)) {
             config.mutation_strength = mut_str;
+            changed = true;
         }
         ImGui::Unindent();
     }
@@ -133,23 +140,20 @@ void ImGuiPanel::render_config_panel(SimulationConfig& config, World* world) {
     // Agent parameters
     ImGui::Text("Population Controls");
     if (ImGui::Button("Spawn 10 Prey")) {
-        if (world) {
-            world->spawn_prey(10);
-            std::cout << "[UI] Spawned 10 prey\n";
-        }
+        send(commands, {SimCommand::Type::SpawnPrey, 10});
+        std::cout << "[UI] Spawned 10 prey\n";
     }
     ImGui::SameLine();
     if (ImGui::Button("Spawn 5 Predators")) {
-        if (world) {
-            world->spawn_predators(5);
-            std::cout << "[UI] Spawned 5 predators\n";
-        }
+        send(commands, {SimCommand::Type::SpawnPredators, 5});
+        std::cout << "[UI] Spawned 5 predators\n";
     }
     
     ImGui::Separator();
     float predator_chance = static_cast<float>(config.predator_chance);
     if (ImGui::SliderFloat("Predator Spawn %", &predator_chance, 0.0f, 1.0f)) {
         config.predator_chance = predator_chance;
+        changed = true;
     }
     
     // Energy parameters
@@ -158,16 +162,19 @@ void ImGuiPanel::render_config_panel(SimulationConfig& config, World* world) {
     float consumption = static_cast<float>(config.energy_consumption_rate);
     if (ImGui::SliderFloat("Consumption Rate", &consumption, 0.0f, 2.0f)) {
         config.energy_consumption_rate = consumption;
+        changed = true;
     }
     
     float gain = static_cast<float>(config.energy_gain_from_prey);
     if (ImGui::SliderFloat("Energy from Prey", &gain, 0.0f, 150.0f)) {
         config.energy_gain_from_prey = gain;
+        changed = true;
     }
     
     float repro_threshold = static_cast<float>(config.reproduction_energy_threshold);
     if (ImGui::SliderFloat("Reproduction Threshold", &repro_threshold, 50.0f, 200.0f)) {
         config.reproduction_energy_threshold = repro_threshold;
+        changed = true;
     }
     
     // Interaction parameters
@@ -177,11 +184,13 @@ void ImGuiPanel::render_config_panel(SimulationConfig& config, World* world) {
         float chase = static_cast<float>(config.predator_chase_strength);
         if (ImGui::SliderFloat("Chase Strength", &chase, 0.0f, 0.1f)) {
             config.predator_chase_strength = chase;
+            changed = true;
         }
         
         float flee = static_cast<float>(config.prey_flee_strength);
         if (ImGui::SliderFloat("Flee Strength", &flee, 0.0f, 0.1f)) {
             config.prey_flee_strength = flee;
+            changed = true;
         }
     } else {
         ImGui::TextDisabled("Chase/Flee (AI Controlled)");
@@ -190,20 +199,27 @@ void ImGuiPanel::render_config_panel(SimulationConfig& config, World* world) {
     float separation = static_cast<float>(config.separation_strength);
     if (ImGui::SliderFloat("Separation", &separation, 0.0f, 0.1f)) {
         config.separation_strength = separation;
+        changed = true;
     }
     
     // Visualization
     ImGui::Separator();
     ImGui::Text("Visualization");
     if (ImGui::Checkbox("Show Trails", &config.show_trails)) {
+        changed = true;
         std::cout << (config.show_trails ? "[Trails ON]\n" : "[Trails OFF]\n");
     }
     if (config.show_trails) {
         int trail_len = config.trail_length;
         if (ImGui::SliderInt("Trail Length", &trail_len, 5, 50)) {
             config.trail_length = trail_len;
+            changed = true;
         }
     }
+    if (ImGui::SliderInt("Heatmap Above", &config.heatmap_threshold, 0, 1000000, "%d agents",
+                         ImGuiSliderFlags_Logarithmic)) {
+        changed = true;
+    }
     
     ImGui::Separator();
     if (ImGui::Button("Save Config")) {
@@ -213,19 +229,22 @@ void ImGuiPanel::render_config_panel(SimulationConfig& config, World* world) {
     ImGui::SameLine();
     if (ImGui::Button("Reload Config")) {
         config.load_from_file("config.json");
+        changed = true;
         std::cout << "[Config] Reloaded from config.json\n";
     }
     
     ImGui::End();
+
+    if (changed) send(commands, {SimCommand::Type::SetConfig, 0, false, config});
 }
 
-void ImGuiPanel::render_stats_panel(const Statistics* stats) {
+void ImGuiPanel::render_stats_panel(const RenderSnapshot& frame) {
     ImGui::Begin("Statistics & AI Evolution", &show_stats_window_);
     
-    ImGui::Text("Total Births: %d", stats->total_births());
-    ImGui::Text("Total Deaths: %d", stats->total_deaths());
+    ImGui::Text("Total Births: %d", frame.total_births);
+    ImGui::Text("Total Deaths: %d", frame.total_deaths);
     
-    const auto& history = stats->get_history();
+    const auto& history = frame.history;
     if (!history.empty()) {
         const auto& latest = history.back();
         ImGui::Separator();
@@ -250,6 +269,13 @@ void ImGuiPanel::render_stats_panel(const Statistics* stats) {
         ImGui::Text("Average Energy: %.1f", latest.avg_energy);
         ImGui::Text("  Predator Energy: %.1f", latest.avg_predator_energy);
         ImGui::Text("  Prey Energy: %.1f", latest.avg_prey_energy);
+
+        ImGui::Separator();
+        ImGui::Text("Distributions (p50 / p90):");
+        ImGui::Text("  Energy: %.1f / %.1f (p10 %.1f)", latest.energy_p50, latest.energy_p90, latest.energy_p10);
+        ImGui::Text("  Age: %.0f / %.0f", latest.age_p50, latest.age_p90);
+        ImGui::Text("  Generation: %.0f / %.0f", latest.generation_p50, latest.generation_p90);
+        ImGui::Text("  Kills (p90): %.1f", latest.kills_p90);
         
         // Simple population graph
         if (history.size() > 1) {
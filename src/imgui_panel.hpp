@@ -1,5 +1,7 @@
 #pragma once
 #include "config.hpp"
+#include "render_snapshot.hpp"
+#include "sim_command.hpp"
 #include <SDL2/SDL.h>
 
 // Forward declarations
@@ -15,7 +17,9 @@ public:
     
     bool process_event(SDL_Event* event);
     void begin_frame();
-    void render(SimulationConfig& config, const class Statistics* stats, class World* world = nullptr);
+    // config is the window's copy: edits to it and spawn requests are sent to
+    // the simulation thread through commands
+    void render(SimulationConfig& config, const RenderSnapshot& frame, SimCommandQueue& commands);
     void end_frame();
 
     bool wants_capture_mouse() const;
@@ -28,6 +32,6 @@ private:
     SDL_Window* window_ = nullptr;
     SDL_Renderer* renderer_ = nullptr;
 
-    void render_config_panel(SimulationConfig& config, class World* world);
-    void render_stats_panel(const Statistics* stats);
+    void render_config_panel(SimulationConfig& config, SimCommandQueue& commands);
+    void render_stats_panel(const RenderSnapshot& frame);
 };
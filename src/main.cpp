@@ -4,9 +4,16 @@
 #include "config.hpp"
 #include "statistics.hpp"
 #include "imgui_panel.hpp"
+#include "replay.hpp"
+#include "render_snapshot.hpp"
+#include "sim_command.hpp"
+#include "triple_buffer.hpp"
 #include <SDL2/SDL.h>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <thread>
+#include <memory>
 
 int main() {
     // Load configuration
@@ -18,23 +25,36 @@ int main() {
 
     World world(config, config.seed);
     Visualizer viz;
-    viz.init(config.window_width, config.window_height);
+    viz.init(config.window_width, config.window_height, config.num_threads);
 
     // Initialize statistics
-    Statistics stats(config.stats_output_file, config.enable_stats);
+    Statistics stats(config.stats_output_file, config.enable_stats, StatsOptions::from_config(config));
     world.set_statistics(&stats);
 
+    // Optional replay log of spawns and config changes
+    std::unique_ptr<ReplayRecorder> recorder;
+    if (!config.replay_output_file.empty()) {
+        recorder = std::make_unique<ReplayRecorder>(config.replay_output_file, config, config.seed,
+                                                    config.keyframe_interval);
+        world.set_recorder(recorder.get());
+    }
+
     // Initialize ImGui
     ImGuiPanel gui;
     gui.init(viz.get_window(), viz.get_renderer());
 
     Scheduler scheduler(config.dt, config.max_steps, config.seed);
-    scheduler.enable_profiling(false);
-
-    bool running = true;
-    bool paused = false;
-    SDL_Event e;
-    int current_step = 0;
+    scheduler.enable_profiling(config.enable_profiling);
+    scheduler.set_trace_file(config.trace_output_file);
+    world.set_profiler(&scheduler.profiler());
+
+    // The simulation steps on its own thread and hands the window immutable
+    // snapshots through a triple buffer; the window sends spawns and config
+    // edits back through a command queue, applied between steps. Neither side
+    // waits for the other, so a slow frame never holds up the simulation.
+    TripleBuffer<RenderSnapshot> frames;
+    SimCommandQueue commands(256);
+    std::atomic<bool> sim_running{true};
 
     scheduler.set_on_start([&]() {
         std::cout << "[Polaris] Simulation started.\n";
@@ -52,23 +72,89 @@ int main() {
         std::cout << "[Polaris] Total deaths: " << stats.total_deaths() << "\n";
     });
 
-    scheduler.set_on_step([&](int step, double dt) {
-        current_step = step;
+    // Called from the step below once the world has actually advanced; a
+    // step cut short by Quit still reaches the scheduler's on_step
+    auto record_stats = [&](int step, double dt) {
         if (step % config.stats_interval == 0) {
+            ScopedPhase scope(&scheduler.profiler(), Phase::Stats);
             std::cout << "[Tick " << step << "] Population: " << world.agents.size()
                      << " (P:" << world.count_predators() 
                      << " Y:" << world.count_prey() << ")" << std::endl;
             stats.record_step(step, step * dt, world);
         }
+    };
+
+    // Simulation thread state
+    bool sim_paused = false;
+    bool quit = false;
+
+    auto apply_commands = [&]() {
+        SimCommand command;
+        while (commands.try_pop(command)) {
+            switch (command.type) {
+                case SimCommand::Type::SpawnPrey: world.spawn_prey(command.count); break;
+                case SimCommand::Type::SpawnPredators: world.spawn_predators(command.count); break;
+                case SimCommand::Type::SetConfig:
+                    config = command.config;
+                    if (recorder) recorder->record_config(world, config);
+                    break;
+                case SimCommand::Type::SetPaused: sim_paused = command.paused; break;
+                case SimCommand::Type::Quit:
+                    quit = true;
+                    scheduler.pause();  // Ends run() after this step
+                    break;
+            }
+        }
+    };
+
+    // Capture only once the window has taken the previous frame, so a fast
+    // simulation does not spend its time copying frames nobody draws
+    auto publish_frame = [&]() {
+        if (frames.pending()) return;
+        frames.back().capture(world, &stats);
+        frames.publish();
+    };
+
+    publish_frame();
+    std::thread sim_thread([&]() {
+        scheduler.run([&](double stepDt, int step) {
+            apply_commands();
+            while (sim_paused && !quit) {
+                publish_frame();  // Spawns still show up while paused
+                std::this_thread::sleep_for(std::chrono::milliseconds(16));
+                apply_commands();
+            }
+            if (quit) return;
+
+            if (recorder) recorder->before_step(world);
+            world.update(stepDt);
+            if (recorder) recorder->after_step(world);
+            record_stats(step, stepDt);
+            publish_frame();
+        });
+        sim_running = false;
     });
 
-    scheduler.run([&](double stepDt, int step) {
+    // Window thread: events, then the newest frame at the display rate. It
+    // edits its own copy of the config and sends it over whole.
+    SimulationConfig ui_config = config;
+    bool running = true;
+    bool paused = false;
+    SDL_Event e;
+
+    auto send = [&](const SimCommand& command) {
+        if (!commands.try_push(command)) std::cout << "[Polaris] Simulation busy, request dropped\n";
+    };
+
+    while (running && sim_running) {
         // ImGui new frame
         gui.begin_frame();
 
         // Handle events each frame
         while (SDL_PollEvent(&e)) {
             gui.process_event(&e);
+            // Releasing the button always ends a drag, even over a panel
+            if (!gui.wants_capture_mouse() || e.type == SDL_MOUSEBUTTONUP) viz.handle_event(e);
 
             if (e.type == SDL_QUIT) running = false;
             if (e.type == SDL_KEYDOWN) {
@@ -76,40 +162,43 @@ int main() {
                     case SDLK_ESCAPE: running = false; break;
                     case SDLK_SPACE:
                         paused = !paused;
+                        send({SimCommand::Type::SetPaused, 0, paused});
                         std::cout << (paused ? "[Paused]\n" : "[Resumed]\n");
                         break;
                     case SDLK_r:
-                        config.load_from_file("config.json");
+                        ui_config.load_from_file("config.json");
+                        send({SimCommand::Type::SetConfig, 0, false, ui_config});
                         std::cout << "[Config reloaded]\n";
                         break;
                     case SDLK_t:
-                        config.show_trails = !config.show_trails;
-                        std::cout << (config.show_trails ? "[Trails ON]\n" : "[Trails OFF]\n");
+                        ui_config.show_trails = !ui_config.show_trails;
+                        send({SimCommand::Type::SetConfig, 0, false, ui_config});
+                        std::cout << (ui_config.show_trails ? "[Trails ON]\n" : "[Trails OFF]\n");
+                        break;
+                    case SDLK_0:
+                        viz.reset_view();
                         break;
                 }
             }
         }
 
-        if (!running) return;
-        if (paused) {
-            // Still render UI when paused
-            viz.draw(world);
-            gui.render(config, &stats, &world);
+        frames.update();
+        {
+            ScopedPhase scope(&scheduler.profiler(), Phase::Render);
+            viz.draw(frames.front(), ui_config.heatmap_threshold);
+
+            // Render ImGui (after world draw so it appears on top)
+            gui.render(ui_config, frames.front(), commands);
             gui.end_frame();
-            SDL_Delay(16);
-            return;
         }
 
-        world.update(stepDt);
-        viz.draw(world);
-
-        // Render ImGui (after world draw so it appears on top)
-        gui.render(config, &stats, &world);
-        gui.end_frame();
-
         // Cap frame rate
-        SDL_Delay(1000 / config.render_fps);
-    });
+        SDL_Delay(1000 / ui_config.render_fps);
+    }
+
+    // Closing the window stops the simulation; it may also have run out of steps
+    while (sim_running && !commands.try_push({SimCommand::Type::Quit})) std::this_thread::yield();
+    sim_thread.join();
 
     gui.shutdown();
     viz.shutdown();
@@ -1,162 +1,109 @@
 #include "neural_network.hpp"
+#include "simd.hpp"
 #include <algorithm>
 
-NeuralNetwork::NeuralNetwork(int input_size, int hidden_size, int output_size, unsigned seed)
-    : input_size_(input_size), hidden_size_(hidden_size), output_size_(output_size) {
-    
-    std::mt19937 rng(seed);
-    std::normal_distribution<double> dist(0.0, 0.5);
-    
+void network_init(const NetworkShape& shape, Real* params, CounterRng rng) {
     // Initialize weights with Xavier initialization
-    double limit_ih = std::sqrt(6.0 / (input_size + hidden_size));
-    double limit_ho = std::sqrt(6.0 / (hidden_size + output_size));
+    double limit_ih = std::sqrt(6.0 / (shape.input + shape.hidden));
+    double limit_ho = std::sqrt(6.0 / (shape.hidden + shape.output));
     
-    std::uniform_real_distribution<double> dist_ih(-limit_ih, limit_ih);
-    std::uniform_real_distribution<double> dist_ho(-limit_ho, limit_ho);
+    std::fill_n(params, shape.param_count(), Real(0));
+    Real* w = params;
     
     // Input to hidden weights
-    weights_input_hidden_.resize(input_size_);
-    for (int i = 0; i < input_size_; ++i) {
-        weights_input_hidden_[i].resize(hidden_size_);
-        for (int j = 0; j < hidden_size_; ++j) {
-            weights_input_hidden_[i][j] = dist_ih(rng);
-        }
+    for (int i = 0; i < shape.input * shape.hidden; ++i) {
+        *w++ = static_cast<Real>(rng.uniform(-limit_ih, limit_ih));
     }
     
-    bias_hidden_.resize(hidden_size_, 0.0);
+    // Hidden biases start at zero
+    w += shape.hidden;
     
     // Hidden to output weights
-    weights_hidden_output_.resize(hidden_size_);
-    for (int i = 0; i < hidden_size_; ++i) {
-        weights_hidden_output_[i].resize(output_size_);
-        for (int j = 0; j < output_size_; ++j) {
-            weights_hidden_output_[i][j] = dist_ho(rng);
-        }
+    for (int i = 0; i < shape.hidden * shape.output; ++i) {
+        *w++ = static_cast<Real>(rng.uniform(-limit_ho, limit_ho));
     }
     
-    bias_output_.resize(output_size_, 0.0);
+    // Output biases start at zero
 }
 
-double NeuralNetwork::activation(double x) const {
-    return std::tanh(x);
+void network_mutate(const NetworkShape& shape, Real* params,
+                    double rate, double strength, CounterRng rng) {
+    // Weights and biases of both layers, in packed order
+    Real* end = params + shape.param_count();
+    for (Real* w = params; w != end; ++w) {
+        if (rng.uniform() < rate) {
+            *w += static_cast<Real>(rng.normal() * strength);
+            *w = std::clamp(*w, Real(-2), Real(2));
+        }
+    }
 }
 
-double NeuralNetwork::tanh_activation(double x) const {
-    return std::tanh(x);
+NeuralNetwork::NeuralNetwork(int input_size, int hidden_size, int output_size, unsigned seed)
+    : shape_{input_size, hidden_size, output_size}, seed_(seed), params_(shape_.param_count()) {
+    network_init(shape_, params_.data(), CounterRng(seed, 0, 0, RngStream::BrainInit));
 }
 
-std::vector<double> NeuralNetwork::forward(const std::vector<double>& inputs) {
-    // Hidden layer
-    std::vector<double> hidden(hidden_size_, 0.0);
-    for (int j = 0; j < hidden_size_; ++j) {
-        double sum = bias_hidden_[j];
-        for (int i = 0; i < input_size_; ++i) {
-            sum += inputs[i] * weights_input_hidden_[i][j];
+// One dense layer with tanh: out[j] = tanh(b[j] + sum_i in[i] * W[i][j]).
+// W is row-major [n_in][n_out], so each input row is a contiguous stride-1
+// load and the loop vectorizes across outputs.
+static void dense_tanh(const Real* in, int n_in, const Real* weights,
+                       const Real* bias, int n_out, Real* out) {
+    int j = 0;
+    for (; j + VecR::width <= n_out; j += VecR::width) {
+        VecR acc = VecR::load(bias + j);
+        for (int i = 0; i < n_in; ++i) {
+            acc = fmadd(VecR::broadcast(in[i]), VecR::load(weights + i * n_out + j), acc);
         }
-        hidden[j] = activation(sum);
+        tanh_approx(acc).store(out + j);
     }
-    
-    // Output layer
-    std::vector<double> outputs(output_size_, 0.0);
-    for (int j = 0; j < output_size_; ++j) {
-        double sum = bias_output_[j];
-        for (int i = 0; i < hidden_size_; ++i) {
-            sum += hidden[i] * weights_hidden_output_[i][j];
+    // Leftover outputs as one masked vector rather than one at a time; layer
+    // sizes like 12 are narrower than a whole float vector on AVX-512
+    if (j < n_out) {
+        const int rest = n_out - j;
+        VecR acc = VecR::load_partial(bias + j, rest);
+        for (int i = 0; i < n_in; ++i) {
+            acc = fmadd(VecR::broadcast(in[i]), VecR::load_partial(weights + i * n_out + j, rest), acc);
         }
-        outputs[j] = tanh_activation(sum);
+        tanh_approx(acc).store_partial(out + j, rest);
     }
-    
+}
+
+void network_forward(const NetworkShape& shape, const Real* params,
+                     const Real* inputs, Real* outputs, Real* scratch) {
+    const Real* w_ih = params;
+    const Real* b_h = w_ih + shape.input * shape.hidden;
+    const Real* w_ho = b_h + shape.hidden;
+    const Real* b_o = w_ho + shape.hidden * shape.output;
+
+    dense_tanh(inputs, shape.input, w_ih, b_h, shape.hidden, scratch);
+    dense_tanh(scratch, shape.hidden, w_ho, b_o, shape.output, outputs);
+}
+
+void NeuralNetwork::forward(const Real* inputs, Real* outputs, Real* scratch) const {
+    network_forward(shape_, params_.data(), inputs, outputs, scratch);
+}
+
+std::vector<Real> NeuralNetwork::forward(const std::vector<Real>& inputs) {
+    std::vector<Real> hidden(shape_.hidden);
+    std::vector<Real> outputs(shape_.output);
+    forward(inputs.data(), outputs.data(), hidden.data());
     return outputs;
 }
 
 void NeuralNetwork::mutate(double mutation_rate, double mutation_strength) {
-    std::random_device rd;
-    std::mt19937 rng(rd());
-    std::uniform_real_distribution<double> prob(0.0, 1.0);
-    std::normal_distribution<double> mutation(0.0, mutation_strength);
-    
-    // Mutate input-hidden weights
-    for (auto& layer : weights_input_hidden_) {
-        for (auto& w : layer) {
-            if (prob(rng) < mutation_rate) {
-                w += mutation(rng);
-                w = std::clamp(w, -2.0, 2.0);
-            }
-        }
-    }
-    
-    // Mutate hidden biases
-    for (auto& b : bias_hidden_) {
-        if (prob(rng) < mutation_rate) {
-            b += mutation(rng);
-            b = std::clamp(b, -2.0, 2.0);
-        }
-    }
-    
-    // Mutate hidden-output weights
-    for (auto& layer : weights_hidden_output_) {
-        for (auto& w : layer) {
-            if (prob(rng) < mutation_rate) {
-                w += mutation(rng);
-                w = std::clamp(w, -2.0, 2.0);
-            }
-        }
-    }
-    
-    // Mutate output biases
-    for (auto& b : bias_output_) {
-        if (prob(rng) < mutation_rate) {
-            b += mutation(rng);
-            b = std::clamp(b, -2.0, 2.0);
-        }
-    }
+    network_mutate(shape_, params_.data(), mutation_rate, mutation_strength,
+                   CounterRng(seed_, 0, mutations_++, RngStream::Mutation));
 }
 
 NeuralNetwork NeuralNetwork::clone() const {
-    NeuralNetwork copy(input_size_, hidden_size_, output_size_, 0);
-    copy.weights_input_hidden_ = weights_input_hidden_;
-    copy.bias_hidden_ = bias_hidden_;
-    copy.weights_hidden_output_ = weights_hidden_output_;
-    copy.bias_output_ = bias_output_;
-    return copy;
+    // Parameters are one contiguous block, so a copy is a single allocation
+    return *this;
 }
 
-std::vector<double> NeuralNetwork::get_weights() const {
-    std::vector<double> all_weights;
-    
-    for (const auto& layer : weights_input_hidden_) {
-        all_weights.insert(all_weights.end(), layer.begin(), layer.end());
-    }
-    all_weights.insert(all_weights.end(), bias_hidden_.begin(), bias_hidden_.end());
-    
-    for (const auto& layer : weights_hidden_output_) {
-        all_weights.insert(all_weights.end(), layer.begin(), layer.end());
-    }
-    all_weights.insert(all_weights.end(), bias_output_.begin(), bias_output_.end());
-    
-    return all_weights;
+std::vector<Real> NeuralNetwork::get_weights() const {
+    return params_;
 }
 
-void NeuralNetwork::set_weights(const std::vector<double>& weights) {
-    size_t idx = 0;
-    
-    for (auto& layer : weights_input_hidden_) {
-        for (auto& w : layer) {
-            w = weights[idx++];
-        }
-    }
-    
-    for (auto& b : bias_hidden_) {
-        b = weights[idx++];
-    }
-    
-    for (auto& layer : weights_hidden_output_) {
-        for (auto& w : layer) {
-            w = weights[idx++];
-        }
-    }
-    
-    for (auto& b : bias_output_) {
-        b = weights[idx++];
-    }
+void NeuralNetwork::set_weights(const std::vector<Real>& weights) {
+    std::copy_n(weights.begin(), std::min(weights.size(), params_.size()), params_.begin());
 }
@@ -1,7 +1,39 @@
 #pragma once
+#include <cstdint>
 #include <vector>
-#include <random>
 #include <cmath>
+#include "real.hpp"
+#include "rng.hpp"
+
+// Layer sizes of a feedforward network
+struct NetworkShape {
+    int input = 0;
+    int hidden = 0;
+    int output = 0;
+
+    // Number of Reals in the packed parameter block
+    size_t param_count() const {
+        return static_cast<size_t>(input) * hidden + hidden +
+               static_cast<size_t>(hidden) * output + output;
+    }
+
+    bool operator==(const NetworkShape&) const = default;
+};
+
+// Forward pass over a packed parameter block laid out as
+// [W_ih (input x hidden, row-major) | b_h | W_ho (hidden x output, row-major) | b_o],
+// the same order get_weights() returns. scratch must hold shape.hidden
+// Reals. Vectorized over each layer's outputs; never allocates.
+void network_forward(const NetworkShape& shape, const Real* params,
+                     const Real* inputs, Real* outputs, Real* scratch);
+
+// Xavier-initialize a packed parameter block in place; biases start at zero
+void network_init(const NetworkShape& shape, Real* params, CounterRng rng);
+
+// Perturb each parameter with probability rate by N(0, strength), clamped to
+// [-2, 2]. The same generator always applies the same mutation.
+void network_mutate(const NetworkShape& shape, Real* params,
+                    double rate, double strength, CounterRng rng);
 
 // Simple feedforward neural network for agent control
 class NeuralNetwork {
@@ -9,28 +41,30 @@ public:
     NeuralNetwork(int input_size, int hidden_size, int output_size, unsigned seed = 42);
     
     // Forward pass: inputs -> outputs
-    std::vector<double> forward(const std::vector<double>& inputs);
+    std::vector<Real> forward(const std::vector<Real>& inputs);
+
+    // Allocation-free forward pass (scratch holds shape().hidden Reals)
+    void forward(const Real* inputs, Real* outputs, Real* scratch) const;
     
-    // Mutate weights for evolution
+    // Mutate weights for evolution; the n-th call draws from the n-th
+    // Mutation stream of the construction seed
     void mutate(double mutation_rate, double mutation_strength);
     
     // Copy network (for reproduction)
     NeuralNetwork clone() const;
     
     // Get/set weights for serialization
-    std::vector<double> get_weights() const;
-    void set_weights(const std::vector<double>& weights);
+    std::vector<Real> get_weights() const;
+    void set_weights(const std::vector<Real>& weights);
+
+    const NetworkShape& shape() const { return shape_; }
+    const Real* params() const { return params_.data(); }
 
 private:
-    int input_size_;
-    int hidden_size_;
-    int output_size_;
-    
-    std::vector<std::vector<double>> weights_input_hidden_;
-    std::vector<double> bias_hidden_;
-    std::vector<std::vector<double>> weights_hidden_output_;
-    std::vector<double> bias_output_;
-    
-    double activation(double x) const;
-    double tanh_activation(double x) const;
+    NetworkShape shape_;
+    unsigned seed_ = 0;
+    uint64_t mutations_ = 0;  // Calls to mutate()
+
+    // All weights and biases in one contiguous block (see network_forward)
+    std::vector<Real> params_;
 };
@@ -0,0 +1,283 @@
+#include "population_stats.hpp"
+#include "agent_store.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+
+// Lower bound and width of a bucket, in scaled units
+void bucket_range(size_t b, double& lo, double& width) {
+    using H = StreamingHistogram;
+    if (b < H::EXACT) {
+        lo = static_cast<double>(b);
+        width = 1.0;
+        return;
+    }
+    const size_t octave = (b - H::EXACT) / H::SUB_BUCKETS;
+    const size_t sub = (b - H::EXACT) % H::SUB_BUCKETS;
+    const int shift = static_cast<int>(octave) + 1;
+    lo = std::ldexp(static_cast<double>(H::SUB_BUCKETS + sub), shift);
+    width = std::ldexp(1.0, shift);
+}
+
+void atomic_add(int64_t& target, int64_t delta) {
+    std::atomic_ref<int64_t>(target).fetch_add(delta, std::memory_order_relaxed);
+}
+
+// An agent of this age at step now was born at the result
+uint64_t birth_step(int age, uint64_t now) {
+    return now - std::min<uint64_t>(static_cast<uint64_t>(std::max(age, 0)), now);
+}
+
+// Equal values in a row are counted up and handed to add() as one call
+template <class Key, class Add>
+class RunCounter {
+public:
+    explicit RunCounter(Add add) : add_(add) {}
+    ~RunCounter() { flush(); }
+
+    void push(Key key) {
+        if (count_ > 0 && key != key_) flush();
+        key_ = key;
+        count_++;
+    }
+    void flush() {
+        if (count_ > 0) add_(key_, count_);
+        count_ = 0;
+    }
+
+private:
+    Add add_;
+    Key key_{};
+    int64_t count_ = 0;
+};
+
+template <class Key, class Add>
+RunCounter<Key, Add> run_counter(Add add) {
+    return RunCounter<Key, Add>(add);
+}
+
+}  // namespace
+
+StreamingHistogram::StreamingHistogram(double scale) : scale_(scale), counts_(BUCKETS, 0) {}
+
+void StreamingHistogram::add(size_t bucket, int64_t count) {
+    atomic_add(counts_[bucket], count);
+    atomic_add(total_, count);
+}
+
+void StreamingHistogram::clear() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_ = 0;
+}
+
+double StreamingHistogram::quantile(double q) const {
+    double value;
+    quantiles(&q, &value, 1);
+    return value;
+}
+
+void StreamingHistogram::quantiles(const double* qs, double* out, size_t n) const {
+    const int64_t total = count();
+    size_t k = 0;
+    int64_t below = 0;
+    for (size_t b = 0; b < counts_.size() && k < n && total > 0; ++b) {
+        const int64_t c = counts_[b];
+        if (c <= 0) continue;
+
+        // Spread the bucket's values evenly over its width
+        double lo, width;
+        bucket_range(b, lo, width);
+        for (; k < n; ++k) {
+            const double rank = std::clamp(qs[k], 0.0, 1.0) * static_cast<double>(total - 1);
+            if (static_cast<double>(below + c) <= rank) break;
+            const double frac = c > 1 ? (rank - static_cast<double>(below)) / static_cast<double>(c - 1) : 0.0;
+            out[k] = (lo + (width - 1.0) * std::clamp(frac, 0.0, 1.0)) / scale_;
+        }
+        below += c;
+    }
+    for (; k < n; ++k) out[k] = 0.0;
+}
+
+size_t AgeHistogram::find(uint64_t birth_step) const {
+    // Last block starting at or before birth_step
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), birth_step,
+                               [](uint64_t step, const Block& b) { return step < b.first; });
+    return static_cast<size_t>(it - blocks_.begin()) - 1;
+}
+
+void AgeHistogram::add(uint64_t birth_step, int64_t count) {
+    // Births almost always land in the newest block or just after it
+    if (blocks_.empty() || birth_step > blocks_.back().last) {
+        blocks_.push_back({birth_step, birth_step, count});
+        return;
+    }
+    if (birth_step < blocks_.front().first) {
+        blocks_.insert(blocks_.begin(), {birth_step, birth_step, count});
+        return;
+    }
+    const size_t b = find(birth_step);
+    if (birth_step <= blocks_[b].last) {
+        blocks_[b].count += count;
+    } else {
+        blocks_.insert(blocks_.begin() + static_cast<std::ptrdiff_t>(b) + 1, {birth_step, birth_step, count});
+    }
+}
+
+void AgeHistogram::remove(uint64_t birth_step) {
+    atomic_add(blocks_[find(birth_step)].count, -1);
+}
+
+void AgeHistogram::compact(uint64_t now) {
+    size_t w = 0;
+    for (size_t r = 0; r < blocks_.size(); ++r) {
+        const Block& b = blocks_[r];
+        if (b.count == 0) continue;
+        if (w > 0) {
+            // Merge into the previous block if the result stays narrow
+            // enough for the age of its youngest members
+            Block& prev = blocks_[w - 1];
+            const uint64_t width = b.last - prev.first + 1;
+            const uint64_t youngest = now - b.last;
+            if (width <= std::max<uint64_t>(1, youngest / StreamingHistogram::SUB_BUCKETS)) {
+                prev.last = b.last;
+                prev.count += b.count;
+                continue;
+            }
+        }
+        blocks_[w++] = b;
+    }
+    blocks_.resize(w);
+}
+
+int64_t AgeHistogram::count() const {
+    int64_t total = 0;
+    for (const Block& b : blocks_) total += b.count;
+    return total;
+}
+
+double AgeHistogram::quantile(uint64_t now, double q) const {
+    double value;
+    quantiles(now, &q, &value, 1);
+    return value;
+}
+
+void AgeHistogram::quantiles(uint64_t now, const double* qs, double* out, size_t n) const {
+    const int64_t total = count();
+    size_t k = 0;
+    int64_t below = 0;
+    // Youngest first, so the walk runs in increasing age
+    for (size_t r = blocks_.size(); r-- > 0 && k < n && total > 0;) {
+        const Block& b = blocks_[r];
+        if (b.count <= 0) continue;
+
+        const double lo = static_cast<double>(now - b.last);
+        const double width = static_cast<double>(b.last - b.first);
+        for (; k < n; ++k) {
+            const double rank = std::clamp(qs[k], 0.0, 1.0) * static_cast<double>(total - 1);
+            if (static_cast<double>(below + b.count) <= rank) break;
+            const double frac = b.count > 1 ? (rank - static_cast<double>(below)) / static_cast<double>(b.count - 1) : 0.0;
+            out[k] = lo + width * std::clamp(frac, 0.0, 1.0);
+        }
+        below += b.count;
+    }
+    for (; k < n; ++k) out[k] = 0.0;
+}
+
+void PopulationStats::add_energy_fixed(bool predator, int64_t delta) {
+    if (delta != 0) atomic_add(energy_fixed_[predator], delta);
+}
+
+void PopulationStats::update(const AgentStore& agents, size_t i, int64_t sign) {
+    const bool predator = agents.predator[i];
+    atomic_add(count_[predator], sign);
+    atomic_add(energy_fixed_[predator], sign * to_fixed(agents.energy[i]));
+    atomic_add(generation_sum_, sign * agents.generation[i]);
+    generation.add(generation.bucket(agents.generation[i]), sign);
+    kills.add(kills.bucket(agents.kills[i]), sign);
+}
+
+void PopulationStats::add_agent(const AgentStore& agents, size_t i, uint64_t now) {
+    update(agents, i, 1);
+    age.add(birth_step(agents.age[i], now));
+}
+
+void PopulationStats::remove_agent(const AgentStore& agents, size_t i, uint64_t now) {
+    update(agents, i, -1);
+    age.remove(birth_step(agents.age[i], now));
+}
+
+void PopulationStats::add_agents(const AgentStore& agents, size_t begin, size_t end, uint64_t now) {
+    int64_t count[2] = {}, energy_fixed[2] = {}, generation_sum = 0;
+    {
+        // Siblings mostly share every bucket, so the runs are long
+        auto hist_add = [](StreamingHistogram& h) { return [&h](size_t b, int64_t n) { h.add(b, n); }; };
+        auto generation_run = run_counter<size_t>(hist_add(generation));
+        auto kills_run = run_counter<size_t>(hist_add(kills));
+        auto age_run = run_counter<uint64_t>([this](uint64_t birth, int64_t n) { age.add(birth, n); });
+        for (size_t i = begin; i < end; ++i) {
+            const bool predator = agents.predator[i];
+            count[predator]++;
+            energy_fixed[predator] += to_fixed(agents.energy[i]);
+            generation_sum += agents.generation[i];
+            generation_run.push(generation.bucket(agents.generation[i]));
+            kills_run.push(kills.bucket(agents.kills[i]));
+            age_run.push(birth_step(agents.age[i], now));
+        }
+    }
+    for (int p = 0; p < 2; ++p) {
+        count_[p] += count[p];
+        energy_fixed_[p] += energy_fixed[p];
+    }
+    generation_sum_ += generation_sum;
+}
+
+void PopulationStats::energy_quantiles(const AgentStore& agents, const double* qs, double* out,
+                                       size_t n) const {
+    // Evenly strided slots, so the sample is the same for any thread count
+    const size_t slots = agents.size();
+    const size_t samples = std::min(slots, ENERGY_SAMPLES);
+    std::vector<Real> sample;
+    sample.reserve(samples);
+    for (size_t k = 0; k < samples; ++k) {
+        const size_t i = k * slots / samples;
+        if (agents.alive(i)) sample.push_back(agents.energy[i]);
+    }
+    if (sample.empty()) {
+        std::fill(out, out + n, 0.0);
+        return;
+    }
+
+    // Each selection only has to search what lies above the previous one
+    auto first = sample.begin();
+    for (size_t k = 0; k < n; ++k) {
+        const double rank = std::clamp(qs[k], 0.0, 1.0) * static_cast<double>(sample.size() - 1);
+        const auto lo = sample.begin() + static_cast<std::ptrdiff_t>(rank);
+        std::nth_element(first, lo, sample.end());
+        const double next = lo + 1 < sample.end() ? *std::min_element(lo + 1, sample.end()) : *lo;
+        out[k] = *lo + (next - *lo) * (rank - std::floor(rank));
+        first = lo;
+    }
+}
+
+void PopulationStats::recount(const AgentStore& agents, uint64_t now) {
+    count_[0] = count_[1] = 0;
+    energy_fixed_[0] = energy_fixed_[1] = 0;
+    generation_sum_ = 0;
+    age.clear();
+    generation.clear();
+    kills.clear();
+
+    // Ages go in oldest first so every birth step appends a block
+    std::vector<uint64_t> births;
+    births.reserve(agents.size());
+    for (size_t i = 0; i < agents.size(); ++i) {
+        if (!agents.alive(i)) continue;
+        update(agents, i, 1);
+        births.push_back(birth_step(agents.age[i], now));
+    }
+    std::sort(births.begin(), births.end());
+    for (uint64_t birth : births) age.add(birth);
+    age.compact(now);
+}
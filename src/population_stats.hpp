@@ -0,0 +1,215 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "agent.hpp"
+
+struct AgentStore;
+
+/**
+ * @brief Streaming histogram of a non-negative quantity, for quantiles.
+ *
+ * Values are scaled to integers and binned log-linearly: exact below
+ * 2 * SUB_BUCKETS, then SUB_BUCKETS buckets per power of two, so every
+ * bucket is narrower than 1/SUB_BUCKETS of its values. Agents move between
+ * buckets as their value changes and nothing is ever rescanned; a quantile
+ * walks the fixed set of buckets, whatever the population.
+ *
+ * add() and move() may be called from several threads at once.
+ *
+ * Example usage:
+ *
+ * StreamingHistogram kills;
+ * kills.add(kills.bucket(0), 1);                  // Birth
+ * kills.move(kills.bucket(k), kills.bucket(k + 1));  // A kill
+ * double p90 = kills.quantile(0.9);
+ */
+class StreamingHistogram {
+public:
+    static constexpr int SUB_BITS = 6;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr uint64_t EXACT = 2 * SUB_BUCKETS;  // Scaled values below this get their own bucket
+    static constexpr int MAX_BITS = 32;                 // Scaled values are clamped below 2^32
+    static constexpr size_t BUCKETS = EXACT + (MAX_BITS - SUB_BITS - 1) * SUB_BUCKETS;
+
+    explicit StreamingHistogram(double scale = 1.0);
+
+    [[nodiscard]] size_t bucket(double value) const {
+        const double scaled = value * scale_;
+        if (!(scaled >= 1.0)) return 0;  // Also catches NaN
+        const uint64_t v = scaled < 0x1p32 ? static_cast<uint64_t>(scaled) : (uint64_t{1} << MAX_BITS) - 1;
+        if (v < EXACT) return static_cast<size_t>(v);
+
+        // The SUB_BITS bits below the leading one pick the sub-bucket
+        const int top = std::bit_width(v) - 1;
+        const uint64_t sub = (v >> (top - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return static_cast<size_t>(EXACT + static_cast<uint64_t>(top - SUB_BITS - 1) * SUB_BUCKETS + sub);
+    }
+
+    void add(size_t bucket, int64_t count);
+    void move(size_t from, size_t to) {
+        if (from == to) return;
+        add(from, -1);
+        add(to, 1);
+    }
+    void clear();
+
+    [[nodiscard]] int64_t count() const { return total_; }
+    // Interpolated within the bucket; 0 when empty
+    [[nodiscard]] double quantile(double q) const;
+    // Several quantiles in one walk; qs must be ascending
+    void quantiles(const double* qs, double* out, size_t n) const;
+
+private:
+    double scale_;
+    std::vector<int64_t> counts_;
+    int64_t total_ = 0;
+};
+
+/**
+ * @brief Ages of the live population, kept as counts per birth step.
+ *
+ * Every live agent ages by one each step, so binning ages directly would move
+ * every agent every step. Birth steps never change: an agent is added to the
+ * block holding its birth step once and removed when it dies, and an age is
+ * the current step minus the birth step. The newest steps have a block each;
+ * compact() merges older neighbours while the merged block stays narrower
+ * than 1/SUB_BUCKETS of its age, so quantiles are as precise as a
+ * StreamingHistogram's and the block count only grows with the log of the
+ * oldest age.
+ *
+ * remove() may be called from several threads at once; add() and compact()
+ * may not run concurrently with anything else.
+ *
+ * Example usage:
+ *
+ * ages.add(step_count);                // Newborn
+ * ages.remove(step_count - age);       // Death
+ * ages.compact(step_count);            // Once per step
+ * double median = ages.quantile(step_count, 0.5);
+ */
+class AgeHistogram {
+public:
+    // Birth steps must not be in the future
+    void add(uint64_t birth_step, int64_t count = 1);
+    void remove(uint64_t birth_step);
+    void compact(uint64_t now);
+    void clear() { blocks_.clear(); }
+
+    [[nodiscard]] int64_t count() const;
+    [[nodiscard]] double quantile(uint64_t now, double q) const;
+    // Several quantiles in one walk; qs must be ascending
+    void quantiles(uint64_t now, const double* qs, double* out, size_t n) const;
+
+private:
+    struct Block {
+        uint64_t first, last;  // Birth steps covered, inclusive
+        int64_t count;
+    };
+    std::vector<Block> blocks_;  // Disjoint, oldest first
+
+    size_t find(uint64_t birth_step) const;
+};
+
+/**
+ * @brief Population totals and distributions kept up to date by World.
+ *
+ * World reports every birth, death and change of energy or kills as it
+ * happens, so counts, average energies and quantiles can be read at any time
+ * without a pass over the agents. Energy sums are kept in fixed point: integer
+ * sums are exact and do not depend on the order that parallel updates land
+ * in, so they never drift from the agent columns and stay the same for any
+ * thread count.
+ *
+ * Energy is the exception for quantiles: every agent's energy changes every
+ * step, and moving each one between histogram buckets costs more than the
+ * pass it replaces. energy_quantiles() instead reads a fixed-size sample of
+ * slots spread evenly over the store.
+ *
+ * Only live agents are counted. After the columns are replaced wholesale
+ * (checkpoint restore), call recount().
+ *
+ * Example usage:
+ *
+ * world.population.add_agent(agents, idx, world.step_count);
+ * world.population.change_energy(agents.predator[i], old_energy, agents.energy[i]);
+ * double avg = world.population.avg_energy(true);
+ */
+class PopulationStats {
+public:
+    static constexpr double ENERGY_FIXED_SCALE = 16777216.0;  // 2^24
+    static constexpr size_t ENERGY_SAMPLES = 1024;           // Slots read by energy_quantiles()
+
+    class EnergyBatch;
+
+    AgeHistogram age;
+    StreamingHistogram generation;
+    StreamingHistogram kills;
+
+    // Any fixed rounding works as long as every update uses the same one
+    static int64_t to_fixed(Real e) { return static_cast<int64_t>(static_cast<double>(e) * ENERGY_FIXED_SCALE); }
+
+    // Agent i joins or leaves the live population, with its current columns.
+    // now is the world's step_count, from which ages give birth steps.
+    void add_agent(const AgentStore& agents, size_t i, uint64_t now);
+    void remove_agent(const AgentStore& agents, size_t i, uint64_t now);
+    // Agents [begin, end) joined together, e.g. a step's offspring; cheaper
+    // than one add_agent() each
+    void add_agents(const AgentStore& agents, size_t begin, size_t end, uint64_t now);
+    void recount(const AgentStore& agents, uint64_t now);
+
+    // Energy change of one agent; parallel loops use an EnergyBatch
+    void change_energy(bool predator, Real from, Real to) {
+        add_energy_fixed(predator, to_fixed(to) - to_fixed(from));
+    }
+    void add_energy_fixed(bool predator, int64_t delta);
+
+    // Exact while the store has at most ENERGY_SAMPLES slots; qs must be ascending
+    void energy_quantiles(const AgentStore& agents, const double* qs, double* out, size_t n) const;
+
+    [[nodiscard]] int predators() const { return static_cast<int>(count_[1]); }
+    [[nodiscard]] int prey() const { return static_cast<int>(count_[0]); }
+    [[nodiscard]] int total() const { return static_cast<int>(count_[0] + count_[1]); }
+    [[nodiscard]] double energy_sum(bool predator) const { return energy_fixed_[predator] / ENERGY_FIXED_SCALE; }
+    [[nodiscard]] double avg_energy(bool predator) const {
+        return count_[predator] > 0 ? energy_sum(predator) / count_[predator] : 0.0;
+    }
+    [[nodiscard]] double avg_energy() const {
+        return total() > 0 ? (energy_sum(false) + energy_sum(true)) / total() : 0.0;
+    }
+    [[nodiscard]] double avg_generation() const {
+        return total() > 0 ? static_cast<double>(generation_sum_) / total() : 0.0;
+    }
+
+private:
+    int64_t count_[2] = {};         // Indexed by predator
+    int64_t energy_fixed_[2] = {};  // Sum of to_fixed(energy)
+    int64_t generation_sum_ = 0;
+
+    void update(const AgentStore& agents, size_t i, int64_t sign);
+};
+
+// Energy changes gathered by one thread, applied to the totals by flush() or
+// on destruction
+class PopulationStats::EnergyBatch {
+public:
+    explicit EnergyBatch(PopulationStats& stats) : stats_(stats) {}
+    ~EnergyBatch() { flush(); }
+
+    EnergyBatch(const EnergyBatch&) = delete;
+    EnergyBatch& operator=(const EnergyBatch&) = delete;
+
+    void change(bool predator, Real from, Real to) {
+        sum_[predator] += to_fixed(to) - to_fixed(from);
+    }
+    void flush() {
+        stats_.add_energy_fixed(false, sum_[0]);
+        stats_.add_energy_fixed(true, sum_[1]);
+        sum_[0] = sum_[1] = 0;
+    }
+
+private:
+    PopulationStats& stats_;
+    int64_t sum_[2] = {};
+};
@@ -0,0 +1,171 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Small stable id per recording thread, for the trace's tid field
+uint32_t thread_index() {
+    static std::atomic<uint32_t> next{0};
+    thread_local uint32_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double p) {
+    const size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+}  // namespace
+
+const char* phase_name(Phase phase) {
+    switch (phase) {
+        case Phase::Step: return "step";
+        case Phase::GridRebuild: return "grid_rebuild";
+        case Phase::Sensing: return "sensing";
+        case Phase::NeuralNet: return "neural_net";
+        case Phase::Interactions: return "interactions";
+        case Phase::Movement: return "movement";
+        case Phase::EnergyReproduction: return "energy_reproduction";
+        case Phase::Compaction: return "compaction";
+        case Phase::Fitness: return "fitness";
+        case Phase::Stats: return "stats";
+        case Phase::Render: return "render";
+        case Phase::Count: break;
+    }
+    return "unknown";
+}
+
+Profiler::Profiler(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)),
+      ring_(std::make_unique<Event[]>(capacity_)),
+      epoch_ns_(steady_ns()) {}
+
+uint64_t Profiler::now_ns() const {
+    return static_cast<uint64_t>(steady_ns() - epoch_ns_);
+}
+
+void Profiler::record(Phase phase, uint64_t start_ns, uint64_t end_ns) {
+    const uint64_t ticket = head_.fetch_add(1, std::memory_order_relaxed);
+    Event& e = ring_[ticket % capacity_];
+
+    // Unpublish while writing. The fence keeps the field stores below from
+    // being ordered before the 0, so a reader that sees any of them also
+    // sees the slot unpublished when it re-checks seq.
+    e.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acq_rel);
+    e.start_ns.store(start_ns, std::memory_order_relaxed);
+    e.duration_ns.store(end_ns - start_ns, std::memory_order_relaxed);
+    e.step.store(step_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    e.thread.store(thread_index(), std::memory_order_relaxed);
+    e.phase.store(phase, std::memory_order_relaxed);
+    e.seq.store(ticket + 1, std::memory_order_release);
+}
+
+template <class F>
+void Profiler::for_each_event(F&& fn) const {
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const uint64_t first = head > capacity_ ? head - capacity_ : 0;
+    for (uint64_t ticket = first; ticket < head; ++ticket) {
+        const Event& e = ring_[ticket % capacity_];
+        if (e.seq.load(std::memory_order_acquire) != ticket + 1) continue;
+        const Record r{e.start_ns.load(std::memory_order_relaxed), e.duration_ns.load(std::memory_order_relaxed),
+                       e.step.load(std::memory_order_relaxed), e.thread.load(std::memory_order_relaxed),
+                       e.phase.load(std::memory_order_relaxed)};
+
+        // Skip the slot if a writer took it over while it was being read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (e.seq.load(std::memory_order_relaxed) != ticket + 1) continue;
+        fn(r);
+    }
+}
+
+std::array<PhaseSummary, static_cast<size_t>(Phase::Count)> Profiler::summarize() const {
+    constexpr size_t num_phases = static_cast<size_t>(Phase::Count);
+    std::array<std::vector<double>, num_phases> samples;
+    for_each_event([&](const Record& e) {
+        samples[static_cast<size_t>(e.phase)].push_back(static_cast<double>(e.duration_ns));
+    });
+
+    std::array<PhaseSummary, num_phases> result;
+    for (size_t p = 0; p < num_phases; ++p) {
+        auto& s = samples[p];
+        if (s.empty()) continue;
+        std::sort(s.begin(), s.end());
+
+        PhaseSummary& out = result[p];
+        out.count = s.size();
+        out.min_ns = s.front();
+        out.p50_ns = percentile(s, 0.50);
+        out.p99_ns = percentile(s, 0.99);
+        out.max_ns = s.back();
+        for (double v : s) out.total_ns += v;
+    }
+    return result;
+}
+
+void Profiler::print_summary(std::ostream& out) const {
+    const auto summary = summarize();
+
+    out << "[Profiler] " << std::left << std::setw(20) << "phase"
+        << std::right << std::setw(8) << "count"
+        << std::setw(11) << "min ms" << std::setw(11) << "p50 ms"
+        << std::setw(11) << "p99 ms" << std::setw(11) << "max ms" << "\n";
+
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    for (size_t p = 0; p < summary.size(); ++p) {
+        const PhaseSummary& s = summary[p];
+        if (s.count == 0) continue;
+        out << "[Profiler] " << std::left << std::setw(20) << phase_name(static_cast<Phase>(p))
+            << std::right << std::setw(8) << s.count
+            << std::setw(11) << s.min_ns * 1e-6 << std::setw(11) << s.p50_ns * 1e-6
+            << std::setw(11) << s.p99_ns * 1e-6 << std::setw(11) << s.max_ns * 1e-6 << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool Profiler::write_chrome_trace(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "[Profiler] Failed to open " << filename << std::endl;
+        return false;
+    }
+
+    // Complete ("X") events; timestamps are in microseconds
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << std::fixed << std::setprecision(3);
+    bool first = true;
+    for_each_event([&](const Record& e) {
+        if (!first) file << ",\n";
+        first = false;
+        file << "{\"name\":\"" << phase_name(e.phase) << "\",\"cat\":\"polaris\",\"ph\":\"X\""
+             << ",\"ts\":" << e.start_ns * 1e-3
+             << ",\"dur\":" << e.duration_ns * 1e-3
+             << ",\"pid\":1,\"tid\":" << e.thread
+             << ",\"args\":{\"step\":" << e.step << "}}";
+    });
+    file << "\n]}\n";
+
+    std::cout << "[Profiler] Trace written to " << filename << std::endl;
+    return true;
+}
+
+void Profiler::clear() {
+    for (size_t i = 0; i < capacity_; ++i) {
+        ring_[i].seq.store(0, std::memory_order_relaxed);
+    }
+    head_.store(0, std::memory_order_release);
+}
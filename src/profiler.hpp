@@ -0,0 +1,138 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+// Phases of a tick that can be timed. Step encloses the others.
+enum class Phase : uint8_t {
+    Step,
+    GridRebuild,
+    Sensing,
+    NeuralNet,
+    Interactions,
+    Movement,
+    EnergyReproduction,
+    Compaction,
+    Fitness,
+    Stats,
+    Render,
+    Count
+};
+
+const char* phase_name(Phase phase);
+
+// Aggregate timings of one phase, in nanoseconds
+struct PhaseSummary {
+    uint64_t count = 0;
+    double min_ns = 0.0;
+    double p50_ns = 0.0;
+    double p99_ns = 0.0;
+    double max_ns = 0.0;
+    double total_ns = 0.0;
+};
+
+/**
+ * @brief Low-overhead phase timer for the simulation loop.
+ *
+ * Timed scopes are written into a fixed-size ring buffer: a writer claims a
+ * slot with one atomic increment and publishes it with a sequence number, so
+ * any thread can record without locks and the oldest events are overwritten
+ * once the buffer is full. Summaries and trace export read whatever the ring
+ * currently holds; a slot is re-checked after it is read, so one that gets
+ * overwritten meanwhile (say by the window thread timing a frame) is skipped
+ * rather than read torn.
+ *
+ * Example usage:
+ *
+ * Profiler profiler;
+ * profiler.set_enabled(true);
+ * {
+ *     ScopedPhase scope(&profiler, Phase::Interactions);
+ *     handle_interactions(dt);
+ * }
+ * profiler.print_summary(std::cout);
+ * profiler.write_chrome_trace("trace.json");
+ */
+class Profiler {
+public:
+    explicit Profiler(size_t capacity = 1 << 16);
+
+    void set_enabled(bool enabled) { enabled_ = enabled; }
+    [[nodiscard]] bool enabled() const { return enabled_; }
+
+    // Step number attached to subsequent events
+    void set_step(int step) { step_.store(step, std::memory_order_relaxed); }
+
+    // Nanoseconds since the profiler was created
+    [[nodiscard]] uint64_t now_ns() const;
+
+    // Record one timed interval (thread-safe, lock-free)
+    void record(Phase phase, uint64_t start_ns, uint64_t end_ns);
+
+    // Per-phase min/p50/p99/max over the events still in the ring
+    [[nodiscard]] std::array<PhaseSummary, static_cast<size_t>(Phase::Count)> summarize() const;
+    void print_summary(std::ostream& out) const;
+
+    // Write the ring as Chrome trace_event JSON (chrome://tracing, Perfetto)
+    bool write_chrome_trace(const std::string& filename) const;
+
+    void clear();
+
+private:
+    struct Record {
+        uint64_t start_ns;
+        uint64_t duration_ns;
+        int32_t step;
+        uint32_t thread;
+        Phase phase;
+    };
+
+    // A ring slot. Fields are relaxed atomics so a reader racing a writer
+    // reads stale values (and then discards them) instead of racing.
+    struct Event {
+        std::atomic<uint64_t> seq{0};  // Claim ticket + 1 once the slot is written, 0 while writing
+        std::atomic<uint64_t> start_ns{0};
+        std::atomic<uint64_t> duration_ns{0};
+        std::atomic<int32_t> step{0};
+        std::atomic<uint32_t> thread{0};
+        std::atomic<Phase> phase{Phase::Step};
+    };
+
+    bool enabled_ = false;
+    size_t capacity_;
+    std::unique_ptr<Event[]> ring_;
+    std::atomic<uint64_t> head_{0};  // Total events ever claimed
+    std::atomic<int> step_{0};
+    int64_t epoch_ns_;
+
+    // Visit a copy of every published event, oldest first
+    template <class F>
+    void for_each_event(F&& fn) const;
+};
+
+/**
+ * @brief Times the enclosing scope as one phase. A null or disabled profiler
+ * makes this a no-op apart from a single branch.
+ */
+class ScopedPhase {
+public:
+    ScopedPhase(Profiler* profiler, Phase phase)
+        : profiler_(profiler && profiler->enabled() ? profiler : nullptr), phase_(phase) {
+        if (profiler_) start_ns_ = profiler_->now_ns();
+    }
+
+    ~ScopedPhase() {
+        if (profiler_) profiler_->record(phase_, start_ns_, profiler_->now_ns());
+    }
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    Profiler* profiler_;
+    Phase phase_;
+    uint64_t start_ns_ = 0;
+};
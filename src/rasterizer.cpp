@@ -0,0 +1,97 @@
+#include "rasterizer.hpp"
+#include "world.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// Bytes R, G, B, A in memory order
+uint32_t rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+    const uint8_t bytes[4] = {r, g, b, a};
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+}  // namespace
+
+void Rasterizer::resize(int width, int height) {
+    width_ = std::max(width, 1);
+    height_ = std::max(height, 1);
+    pixels_.resize(static_cast<size_t>(width_) * height_ * 4);
+}
+
+void Rasterizer::fill_rect(int x, int y, int w, int h, uint32_t color) {
+    const int x0 = std::max(x, 0), x1 = std::min(x + w, width_);
+    const int y0 = std::max(y, 0), y1 = std::min(y + h, height_);
+    if (x0 >= x1) return;
+    for (int row = y0; row < y1; ++row) {
+        uint8_t* line = pixels_.data() + (static_cast<size_t>(row) * width_ + x0) * 4;
+        for (int col = x0; col < x1; ++col, line += 4) std::memcpy(line, &color, 4);
+    }
+}
+
+void Rasterizer::draw(const World& world) {
+    fill_rect(0, 0, width_, height_, rgba(0, 0, 0));
+
+    const uint32_t predator_color = rgba(255, 50, 50);
+    const uint32_t prey_color = rgba(50, 200, 255);
+    const double scale_x = width_ / (2.0 * world.boundary);
+    const double scale_y = height_ / (2.0 * world.boundary);
+    const AgentStore& agents = world.agents;
+    for (size_t i = 0; i < agents.size(); ++i) {
+        if (!agents.alive(i)) continue;
+        const int px = static_cast<int>((agents.pos_x[i] + world.boundary) * scale_x);
+        const int py = static_cast<int>((agents.pos_y[i] + world.boundary) * scale_y);
+        fill_rect(px - AGENT_SIZE / 2, py - AGENT_SIZE / 2, AGENT_SIZE, AGENT_SIZE,
+                  agents.predator[i] ? predator_color : prey_color);
+    }
+}
+
+bool Y4mWriter::open(const std::string& filename, int width, int height, int fps) {
+    close();
+    file_.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        std::cerr << "[Video] Failed to open " << filename << std::endl;
+        return false;
+    }
+    width_ = width;
+    height_ = height;
+    frames_ = 0;
+    planes_.resize(static_cast<size_t>(width) * height * 3);
+    file_ << "YUV4MPEG2 W" << width << " H" << height << " F" << std::max(fps, 1)
+          << ":1 Ip A1:1 C444\n";
+    return static_cast<bool>(file_);
+}
+
+bool Y4mWriter::write(const Rasterizer& raster) {
+    if (!file_.is_open()) return false;
+    if (raster.width() != width_ || raster.height() != height_) {
+        std::cerr << "[Video] Frame is " << raster.width() << "x" << raster.height()
+                  << ", video is " << width_ << "x" << height_ << std::endl;
+        return false;
+    }
+
+    // BT.601 studio range in 8-bit integer arithmetic
+    const size_t n = static_cast<size_t>(width_) * height_;
+    uint8_t* y = planes_.data();
+    uint8_t* cb = y + n;
+    uint8_t* cr = cb + n;
+    const uint8_t* p = raster.pixels();
+    for (size_t i = 0; i < n; ++i, p += 4) {
+        const int r = p[0], g = p[1], b = p[2];
+        y[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        cb[i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        cr[i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+
+    file_ << "FRAME\n";
+    file_.write(reinterpret_cast<const char*>(planes_.data()), static_cast<std::streamsize>(planes_.size()));
+    frames_++;
+    return static_cast<bool>(file_);
+}
+
+void Y4mWriter::close() {
+    if (file_.is_open()) file_.close();
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct World;
+
+/**
+ * @brief Software renderer drawing a world into an RGBA buffer it owns.
+ *
+ * Draws the same picture the offscreen SDL renderer used to (black
+ * background, an 8x8 square per live agent, red predators and blue prey)
+ * with no window, GPU or SDL state. The buffer is kept between frames and
+ * only reallocated when the size changes, so rendering a frame is a clear
+ * plus one square per agent. Pixels are row-major RGBA8, origin top-left.
+ *
+ * Example usage:
+ *
+ * Rasterizer raster(600, 600);
+ * raster.draw(world);
+ * stbi_write_png("frame.png", raster.width(), raster.height(), 4, raster.pixels(), raster.stride());
+ */
+class Rasterizer {
+public:
+    static constexpr int AGENT_SIZE = 8;  // Pixels per side
+
+    explicit Rasterizer(int width = 600, int height = 600) { resize(width, height); }
+
+    void resize(int width, int height);
+    void draw(const World& world);
+
+    [[nodiscard]] const uint8_t* pixels() const { return pixels_.data(); }
+    [[nodiscard]] int width() const { return width_; }
+    [[nodiscard]] int height() const { return height_; }
+    [[nodiscard]] int stride() const { return width_ * 4; }  // Bytes per row
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<uint8_t> pixels_;
+
+    void fill_rect(int x, int y, int w, int h, uint32_t rgba);
+};
+
+/**
+ * @brief Streams frames to an uncompressed YUV4MPEG2 (.y4m) video.
+ *
+ * Frames are converted from RGBA to full-resolution 4:4:4 Y'CbCr (BT.601,
+ * studio range) and appended as they come, so a long episode never sits in
+ * memory. Y4M is understood by ffmpeg and most encoders:
+ *
+ *   ffmpeg -i episode.y4m -c:v libx264 -pix_fmt yuv420p episode.mp4
+ *
+ * Example usage:
+ *
+ * Y4mWriter video;
+ * video.open("episode.y4m", raster.width(), raster.height(), 30);
+ * for (...) { env.step(); raster.draw(world); video.write(raster); }
+ * video.close();
+ */
+class Y4mWriter {
+public:
+    ~Y4mWriter() { close(); }
+
+    bool open(const std::string& filename, int width, int height, int fps);
+    // The raster must have the size the video was opened with
+    bool write(const Rasterizer& raster);
+    void close();
+
+    [[nodiscard]] bool is_open() const { return file_.is_open(); }
+    [[nodiscard]] int width() const { return width_; }
+    [[nodiscard]] int height() const { return height_; }
+    [[nodiscard]] uint64_t frames() const { return frames_; }
+
+private:
+    std::ofstream file_;
+    int width_ = 0;
+    int height_ = 0;
+    uint64_t frames_ = 0;
+    std::vector<uint8_t> planes_;  // Y, Cb, Cr of one frame, reused
+};
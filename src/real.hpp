@@ -0,0 +1,12 @@
+#pragma once
+
+// Scalar type of the simulation state: positions, velocities, energies,
+// fitness and network parameters. Double by default; configuring with
+// -DPOLARIS_FLOAT=ON builds everything in single precision, which halves the
+// memory traffic of the bandwidth-bound phases and doubles the SIMD width.
+// Configuration values, statistics and timings stay double either way.
+#ifdef POLARIS_FLOAT
+using Real = float;
+#else
+using Real = double;
+#endif
@@ -0,0 +1,46 @@
+#include "render_snapshot.hpp"
+#include "world.hpp"
+#include <algorithm>
+
+void RenderSnapshot::capture(const World& world, const Statistics* stats) {
+    const AgentStore& agents = world.agents;
+    const bool trails = world.config && world.config->show_trails;
+
+    step = world.step_count;
+    boundary = world.boundary;
+    wrap = world.grid && world.grid->wraps();
+
+    x.clear();
+    y.clear();
+    energy.clear();
+    predator.clear();
+    trail_begin.clear();
+    trail_x.clear();
+    trail_y.clear();
+
+    for (size_t i = 0; i < agents.size(); ++i) {
+        if (!agents.alive(i)) continue;
+        x.push_back(static_cast<float>(agents.pos_x[i]));
+        y.push_back(static_cast<float>(agents.pos_y[i]));
+        energy.push_back(static_cast<float>(agents.energy[i]));
+        predator.push_back(agents.predator[i]);
+
+        if (!trails) continue;
+        trail_begin.push_back(static_cast<uint32_t>(trail_x.size()));
+        for (size_t k = 0; k < agents.trails.count(i); ++k) {
+            const Vec2 p = agents.trails.point(i, k);
+            trail_x.push_back(static_cast<float>(p.x));
+            trail_y.push_back(static_cast<float>(p.y));
+        }
+    }
+    if (trails) trail_begin.push_back(static_cast<uint32_t>(trail_x.size()));
+
+    history.clear();
+    if (stats) {
+        total_births = stats->total_births();
+        total_deaths = stats->total_deaths();
+        const auto& rows = stats->get_history();
+        const size_t keep = std::min(rows.size(), HISTORY_LENGTH);
+        history.assign(rows.end() - static_cast<std::ptrdiff_t>(keep), rows.end());
+    }
+}
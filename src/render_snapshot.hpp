@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "statistics.hpp"
+
+struct World;
+
+/**
+ * @brief Everything the window draws for one frame, copied out of a World.
+ *
+ * The simulation thread captures a snapshot between steps and hands it to the
+ * render thread through a TripleBuffer, so drawing never touches live agent
+ * columns and a slow frame never holds up a step. Only live agents are
+ * copied, in single precision, and the trail points of agent k are
+ * trail_x/trail_y[trail_begin[k], trail_begin[k + 1]), oldest first (empty
+ * unless trails are shown). capture() overwrites the vectors in place, so a
+ * reused snapshot stops allocating once the population settles.
+ *
+ * The statistics panel reads the totals and the tail of the stats history
+ * from here as well, since Statistics itself belongs to the simulation
+ * thread.
+ *
+ * Example usage:
+ *
+ * RenderSnapshot& frame = frames.back();
+ * frame.capture(world, &stats);
+ * frames.publish();
+ */
+struct RenderSnapshot {
+    static constexpr size_t HISTORY_LENGTH = 100;  // Stats rows kept for the plots
+
+    uint64_t step = 0;
+    double boundary = 0.0;
+    bool wrap = false;  // Opposite edges are joined, so trails can jump across the world
+
+    std::vector<float> x, y, energy;
+    std::vector<uint8_t> predator;
+
+    std::vector<uint32_t> trail_begin;  // agents + 1 offsets, or empty
+    std::vector<float> trail_x, trail_y;
+
+    int total_births = 0;
+    int total_deaths = 0;
+    std::vector<StatsSnapshot> history;  // Last HISTORY_LENGTH rows, oldest first
+
+    void capture(const World& world, const Statistics* stats);
+
+    [[nodiscard]] size_t size() const { return x.size(); }
+    [[nodiscard]] bool has_trails() const { return !trail_begin.empty(); }
+};
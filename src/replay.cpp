@@ -0,0 +1,200 @@
+#include "replay.hpp"
+#include "world.hpp"
+#include "checkpoint.hpp"
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+constexpr char REPLAY_MAGIC[8] = {'P', 'O', 'L', 'R', 'P', 'L', 'Y', '\0'};
+constexpr uint32_t REPLAY_VERSION = 1;
+
+// Little helpers for the fixed-width little-endian-as-written fields
+template <class T>
+void write_raw(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void write_string(std::ofstream& out, const std::string& s) {
+    write_raw<uint32_t>(out, static_cast<uint32_t>(s.size()));
+    out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+template <class T>
+bool read_raw(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+bool read_string(std::ifstream& in, std::string& s) {
+    uint32_t size;
+    if (!read_raw(in, size)) return false;
+    s.resize(size);
+    return static_cast<bool>(in.read(s.data(), size));
+}
+
+}  // namespace
+
+// --- Recording ---
+
+ReplayRecorder::ReplayRecorder(const std::string& filename, const SimulationConfig& config,
+                               unsigned seed, int keyframe_interval)
+    : filename_(filename),
+      file_(filename, std::ios::binary | std::ios::trunc),
+      keyframe_interval_(keyframe_interval),
+      last_config_(config.to_json()) {
+    if (!file_.is_open()) {
+        std::cerr << "[Replay] Failed to open " << filename << std::endl;
+        return;
+    }
+
+    file_.write(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    write_raw<uint32_t>(file_, REPLAY_VERSION);
+    write_raw<uint32_t>(file_, seed);
+    write_raw<int32_t>(file_, keyframe_interval);
+    write_string(file_, last_config_);
+    file_.flush();
+    std::cout << "[Replay] Recording to " << filename << std::endl;
+}
+
+void ReplayRecorder::write_event(ReplayEventType type, uint64_t step, const std::string* text, int count) {
+    if (!file_.is_open()) return;
+    write_raw<uint8_t>(file_, static_cast<uint8_t>(type));
+    write_raw<uint64_t>(file_, step);
+    if (text) write_string(file_, *text);
+    else write_raw<int32_t>(file_, count);
+    file_.flush();
+}
+
+void ReplayRecorder::before_step(const World& world) {
+    if (!has_keyframe_) write_keyframe(world);
+}
+
+void ReplayRecorder::record_config(const World& world, const SimulationConfig& config) {
+    if (!has_keyframe_) write_keyframe(world);  // The change belongs after the initial state
+
+    std::string current = config.to_json();
+    if (current != last_config_) {
+        write_event(ReplayEventType::Config, world.step_count, &current, 0);
+        last_config_ = std::move(current);
+    }
+}
+
+void ReplayRecorder::record_spawn(uint64_t step, bool predators, int count) {
+    write_event(predators ? ReplayEventType::SpawnPredators : ReplayEventType::SpawnPrey,
+                step, nullptr, count);
+}
+
+void ReplayRecorder::after_step(const World& world) {
+    if (keyframe_interval_ > 0 && world.step_count % keyframe_interval_ == 0) {
+        write_keyframe(world);
+    }
+}
+
+void ReplayRecorder::write_keyframe(const World& world) {
+    if (!file_.is_open()) return;
+
+    // Stored by file name only, resolved next to the log when replaying
+    const std::string path = filename_ + "." + std::to_string(world.step_count) + ".ckpt";
+    if (!save_checkpoint(world, path)) return;
+
+    const std::string name = std::filesystem::path(path).filename().string();
+    write_event(ReplayEventType::Keyframe, world.step_count, &name, 0);
+    has_keyframe_ = true;
+}
+
+// --- Playback ---
+
+ReplayPlayer::ReplayPlayer(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "[Replay] Failed to open " << filename << std::endl;
+        return;
+    }
+
+    char magic[sizeof(REPLAY_MAGIC)];
+    uint32_t version = 0;
+    int32_t keyframe_interval = 0;
+    std::string config_text;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 ||
+        !read_raw(in, version) || version != REPLAY_VERSION ||
+        !read_raw(in, seed_) || !read_raw(in, keyframe_interval) ||
+        !read_string(in, config_text) || !initial_config_.load_from_json(config_text)) {
+        std::cerr << "[Replay] " << filename << " is not a replay log (version " << REPLAY_VERSION << ")" << std::endl;
+        return;
+    }
+
+    const std::filesystem::path dir = std::filesystem::path(filename).parent_path();
+    for (;;) {
+        uint8_t type;
+        Event e;
+        if (!read_raw(in, type) || !read_raw(in, e.step)) break;
+        e.type = static_cast<ReplayEventType>(type);
+
+        bool ok;
+        if (e.type == ReplayEventType::Config || e.type == ReplayEventType::Keyframe) {
+            ok = read_string(in, e.text);
+            if (e.type == ReplayEventType::Keyframe) e.text = (dir / e.text).string();
+        } else {
+            int32_t count;
+            ok = read_raw(in, count);
+            e.count = count;
+        }
+
+        // A record cut short by a crash ends the log
+        if (!ok) break;
+        events_.push_back(std::move(e));
+    }
+
+    open_ = true;
+    std::cout << "[Replay] Loaded " << events_.size() << " events from " << filename << std::endl;
+}
+
+void ReplayPlayer::apply_events(World& world, SimulationConfig& config) {
+    while (cursor_ < events_.size() && events_[cursor_].step <= world.step_count) {
+        const Event& e = events_[cursor_++];
+        switch (e.type) {
+            case ReplayEventType::Config: config.load_from_json(e.text); break;
+            case ReplayEventType::SpawnPrey: world.spawn_prey(e.count); break;
+            case ReplayEventType::SpawnPredators: world.spawn_predators(e.count); break;
+            case ReplayEventType::Keyframe: break;
+        }
+    }
+}
+
+void ReplayPlayer::step(World& world, SimulationConfig& config) {
+    apply_events(world, config);
+    world.update(initial_config_.dt);
+}
+
+bool ReplayPlayer::seek(World& world, SimulationConfig& config, uint64_t target_step) {
+    if (!open_) return false;
+
+    // Latest keyframe at or before the target
+    size_t keyframe = events_.size();
+    for (size_t i = 0; i < events_.size() && events_[i].step <= target_step; ++i) {
+        if (events_[i].type == ReplayEventType::Keyframe) keyframe = i;
+    }
+
+    const bool must_rewind = world.step_count > target_step;
+    const bool keyframe_ahead = keyframe < events_.size() && events_[keyframe].step > world.step_count;
+    if (must_rewind || keyframe_ahead) {
+        if (keyframe == events_.size()) {
+            std::cerr << "[Replay] No keyframe at or before step " << target_step << std::endl;
+            return false;
+        }
+
+        // Config as it was when the keyframe was taken
+        config = initial_config_;
+        for (size_t i = 0; i < keyframe; ++i) {
+            if (events_[i].type == ReplayEventType::Config) config.load_from_json(events_[i].text);
+        }
+        if (!load_checkpoint(world, events_[keyframe].text)) return false;
+        cursor_ = keyframe + 1;
+    }
+
+    while (world.step_count < target_step) {
+        step(world, config);
+    }
+    return true;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include "config.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct World;
+
+enum class ReplayEventType : uint8_t {
+    Config = 1,          // Config changed before this step (JSON payload)
+    SpawnPrey = 2,
+    SpawnPredators = 3,
+    Keyframe = 4         // Checkpoint of the state at this step (file name payload)
+};
+
+/**
+ * @brief Deterministic replay logs.
+ *
+ * World::update is deterministic given the world state (including its seed
+ * and next agent id) and the config, so a run can be reproduced from its seed plus the inputs that came
+ * from outside the simulation: spawns triggered from the GUI and config
+ * changes (hot reloads and slider edits). ReplayRecorder appends those
+ * events, tagged with the step they happened before, to a compact binary log.
+ * Every keyframe_interval steps it also writes a checkpoint next to the log
+ * (<log>.<step>.ckpt), so replaying to step N only has to simulate from the
+ * nearest keyframe at or before N.
+ *
+ * Log layout: header (magic, version, seed, keyframe interval, initial
+ * config JSON) followed by records of (type, step, payload). Every record is
+ * flushed as it is written, so a killed run leaves a usable log.
+ *
+ * Worlds are always stepped with the initial config's dt, matching the
+ * Scheduler, which fixes dt when it is created.
+ *
+ * Example usage:
+ *
+ * ReplayRecorder recorder("run.replay", config, seed, 10000);
+ * world.set_recorder(&recorder);
+ * loop { recorder.before_step(world); world.update(dt); recorder.after_step(world); }
+ * on a config change: recorder.record_config(world, config);
+ *
+ * ReplayPlayer player("run.replay");
+ * SimulationConfig config = player.initial_config();
+ * World world(config, player.seed());
+ * player.seek(world, config, 400000);
+ */
+class ReplayRecorder {
+public:
+    ReplayRecorder(const std::string& filename, const SimulationConfig& config,
+                   unsigned seed, int keyframe_interval);
+
+    [[nodiscard]] bool is_open() const { return file_.is_open(); }
+
+    // Call before every World::update. Writes the first keyframe on the
+    // first call.
+    void before_step(const World& world);
+
+    // Call where the running config is replaced, before the next update.
+    // Logged only if it differs from the last one recorded.
+    void record_config(const World& world, const SimulationConfig& config);
+
+    // Called by World::spawn_prey / spawn_predators
+    void record_spawn(uint64_t step, bool predators, int count);
+
+    // Called after World::update; writes a keyframe when one is due
+    void after_step(const World& world);
+
+private:
+    std::string filename_;
+    std::ofstream file_;
+    int keyframe_interval_;
+    std::string last_config_;
+    bool has_keyframe_ = false;
+
+    void write_keyframe(const World& world);
+    void write_event(ReplayEventType type, uint64_t step, const std::string* text, int count);
+};
+
+class ReplayPlayer {
+public:
+    explicit ReplayPlayer(const std::string& filename);
+
+    [[nodiscard]] bool is_open() const { return open_; }
+    [[nodiscard]] unsigned seed() const { return seed_; }
+    [[nodiscard]] const SimulationConfig& initial_config() const { return initial_config_; }
+
+    // Bring world to target_step, restoring the nearest keyframe at or
+    // before it when that is closer than the world's current step. config
+    // must be the object the world was built with; recorded config changes
+    // are applied to it.
+    bool seek(World& world, SimulationConfig& config, uint64_t target_step);
+
+    // Apply the events recorded for world.step_count, then advance one step
+    void step(World& world, SimulationConfig& config);
+
+private:
+    struct Event {
+        ReplayEventType type;
+        uint64_t step;
+        int count = 0;     // Spawns
+        std::string text;  // Config JSON or keyframe path
+    };
+
+    bool open_ = false;
+    unsigned seed_ = 0;
+    SimulationConfig initial_config_;
+    std::vector<Event> events_;  // In recorded order (non-decreasing step)
+    size_t cursor_ = 0;          // Next event to apply
+
+    void apply_events(World& world, SimulationConfig& config);
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+// Independent purposes that draw random numbers for the same agent and step
+enum class RngStream : uint32_t {
+    Layout = 1,     // Position, velocity and kind of a newly placed agent
+    BrainInit = 2,  // Initial network weights
+    Mutation = 3    // Weight mutation of an offspring
+};
+
+/**
+ * @brief Counter-based random numbers (Philox4x32-10).
+ *
+ * A CounterRng is a pure function of the world seed, an agent id, a step and
+ * a stream, plus the index of the draw: it holds no state worth
+ * seeding, costs a few registers to create, and two generators built from
+ * the same four values produce the same sequence on any thread, in any
+ * order. World builds one wherever it needs randomness for an agent, so
+ * nothing depends on which thread got there first or on how many draws
+ * other agents made.
+ *
+ * Uniforms and normals are computed here rather than with <random>
+ * distributions, whose output differs between standard libraries.
+ *
+ * Example usage:
+ *
+ * CounterRng rng(world.seed, agents.id[i], world.step_count, RngStream::Mutation);
+ * if (rng.uniform() < rate) w += rng.normal() * strength;
+ */
+class CounterRng {
+public:
+    // The counter holds the low words of id and step; their high words, zero
+    // until a run passes 2^32 agents or steps, are folded into the key
+    CounterRng(uint32_t seed, uint64_t id, uint64_t step, RngStream stream)
+        : key0_(seed),
+          key1_(static_cast<uint32_t>(id >> 32) ^ static_cast<uint32_t>(step >> 32) * 0x9E3779B9u),
+          counter_{0, static_cast<uint32_t>(id), static_cast<uint32_t>(step),
+                   static_cast<uint32_t>(stream)} {}
+
+    // 32 uniformly distributed bits
+    uint32_t next_u32() {
+        if (used_ == 4) refill();
+        return block_[used_++];
+    }
+
+    // Uniform in [0, 1) with 53 bits of precision
+    double uniform() {
+        const uint64_t hi = next_u32();
+        const uint64_t lo = next_u32();
+        return static_cast<double>(((hi << 32) | lo) >> 11) * 0x1.0p-53;
+    }
+
+    double uniform(double lo, double hi) { return lo + (hi - lo) * uniform(); }
+
+    bool bernoulli(double p) { return uniform() < p; }
+
+    // Standard normal (Box-Muller; the second value of each pair is kept)
+    double normal() {
+        if (has_spare_) {
+            has_spare_ = false;
+            return spare_;
+        }
+        const double u1 = 1.0 - uniform();  // (0, 1], so the log is finite
+        const double u2 = uniform();
+        const double r = std::sqrt(-2.0 * std::log(u1));
+        constexpr double two_pi = 6.283185307179586476925;
+        spare_ = r * std::sin(two_pi * u2);
+        has_spare_ = true;
+        return r * std::cos(two_pi * u2);
+    }
+
+    // Raw Philox4x32-10 block function, exposed for known-answer checks
+    static void philox(uint32_t counter[4], uint32_t key0, uint32_t key1) {
+        constexpr uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+        constexpr uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t p0 = static_cast<uint64_t>(M0) * counter[0];
+            const uint64_t p1 = static_cast<uint64_t>(M1) * counter[2];
+            const uint32_t c1 = counter[1], c3 = counter[3];
+            counter[0] = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ key0;
+            counter[1] = static_cast<uint32_t>(p1);
+            counter[2] = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ key1;
+            counter[3] = static_cast<uint32_t>(p0);
+            key0 += W0;
+            key1 += W1;
+        }
+    }
+
+private:
+    uint32_t key0_, key1_;
+    uint32_t counter_[4];  // Block index, id, step, stream
+    uint32_t block_[4] = {};
+    int used_ = 4;
+    bool has_spare_ = false;
+    double spare_ = 0.0;
+
+    void refill() {
+        for (int k = 0; k < 4; ++k) block_[k] = counter_[k];
+        philox(block_, key0_, key1_);
+        counter_[0]++;
+        used_ = 0;
+    }
+};
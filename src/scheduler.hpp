@@ -2,11 +2,17 @@
 #include <functional>
 #include <chrono>
 #include <iostream>
-#include <random>
 #include <optional>
+#include <string>
+#include "profiler.hpp"
 
 /**
  * @brief A deterministic tick scheduler with timing, callbacks, and optional profiling.
+ *
+ * With profiling enabled every step is timed into the scheduler's Profiler
+ * (World and the step callbacks can add their own phases to it), and a
+ * per-phase summary is printed when run() returns. Set a trace file to also
+ * dump the events as a Chrome trace.
  * 
  * Example usage:
  * 
@@ -26,7 +32,8 @@ class Scheduler {
     std::optional<std::function<void(int, double)>> onStep_;
     std::optional<std::function<void()>> onStart_;
     std::optional<std::function<void()>> onEnd_;
-    bool enableProfiling_ = false;
+    Profiler profiler_;
+    std::string traceFile_;
 
 public:
     Scheduler(double dt, int maxSteps, unsigned long seed = 42)
@@ -35,7 +42,8 @@ public:
     void set_on_start(std::function<void()> fn) { onStart_ = std::move(fn); }
     void set_on_step(std::function<void(int, double)> fn) { onStep_ = std::move(fn); }
     void set_on_end(std::function<void()> fn) { onEnd_ = std::move(fn); }
-    void enable_profiling(bool enable) { enableProfiling_ = enable; }
+    void enable_profiling(bool enable) { profiler_.set_enabled(enable); }
+    void set_trace_file(std::string filename) { traceFile_ = std::move(filename); }
     void pause() { paused_ = true; }
     void resume() { paused_ = false; }
     void reset_seed(unsigned long seed) { seed_ = seed; }
@@ -44,26 +52,25 @@ public:
     void run(UpdateFunc update) {
         if (onStart_) (*onStart_)();
 
-        std::mt19937 rng(seed_);
         for (int i = 0; i < maxSteps_; ++i) {
             if (paused_) break;
 
-            auto startTime = std::chrono::high_resolution_clock::now();
+            profiler_.set_step(i);
+            ScopedPhase stepScope(&profiler_, Phase::Step);
             update(dt_, i);
             if (onStep_) (*onStep_)(i, dt_);
-
-            if (enableProfiling_) {
-                auto endTime = std::chrono::high_resolution_clock::now();
-                std::chrono::duration<double, std::milli> stepDuration = endTime - startTime;
-                std::cout << "[Profiler] Step " << i << " took "
-                          << stepDuration.count() << " ms\n";
-            }
         }
 
         if (onEnd_) (*onEnd_)();
+
+        if (profiler_.enabled()) {
+            profiler_.print_summary(std::cout);
+            if (!traceFile_.empty()) profiler_.write_chrome_trace(traceFile_);
+        }
     }
 
     [[nodiscard]] double dt() const { return dt_; }
     [[nodiscard]] int max_steps() const { return maxSteps_; }
     [[nodiscard]] unsigned long seed() const { return seed_; }
+    [[nodiscard]] Profiler& profiler() { return profiler_; }
 };
@@ -0,0 +1,22 @@
+#pragma once
+#include "config.hpp"
+#include "spsc_queue.hpp"
+
+// A request from the window to the simulation thread, applied between steps
+struct SimCommand {
+    enum class Type {
+        SpawnPrey,       // count prey
+        SpawnPredators,  // count predators
+        SetConfig,       // Replace the running config with config
+        SetPaused,       // Stop or resume stepping
+        Quit
+    };
+
+    Type type = Type::Quit;
+    int count = 0;
+    bool paused = false;
+    SimulationConfig config;
+};
+
+// The window thread pushes, the simulation thread pops
+using SimCommandQueue = SpscQueue<SimCommand>;
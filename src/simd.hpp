@@ -0,0 +1,260 @@
+#pragma once
+#include <algorithm>
+#include <type_traits>
+
+#include "real.hpp"
+
+// Minimal fixed-width SIMD wrapper for the numeric kernels. VecD and VecF map
+// to the widest double- and single-precision vectors enabled at compile time
+// (AVX-512, AVX2+FMA, SSE2) and fall back to a plain scalar otherwise, so
+// kernels are written once against VecR (the vector of Real) and a remainder
+// loop using the scalar overloads. load_partial / store_partial touch only the
+// first n (0 < n < width) lanes, the rest load as zero. select_gt(a, b, x, y)
+// is x where a > b and y elsewhere.
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define POLARIS_SIMD_NAME "avx512"
+
+struct VecD {
+    static constexpr int width = 8;
+    __m512d v;
+
+    static VecD load(const double* p) { return {_mm512_loadu_pd(p)}; }
+    static VecD load_partial(const double* p, int n) { return {_mm512_maskz_loadu_pd(mask(n), p)}; }
+    static VecD broadcast(double x) { return {_mm512_set1_pd(x)}; }
+    void store(double* p) const { _mm512_storeu_pd(p, v); }
+    void store_partial(double* p, int n) const { _mm512_mask_storeu_pd(p, mask(n), v); }
+    static __mmask8 mask(int n) { return static_cast<__mmask8>((1u << n) - 1); }
+};
+
+inline VecD operator+(VecD a, VecD b) { return {_mm512_add_pd(a.v, b.v)}; }
+inline VecD operator*(VecD a, VecD b) { return {_mm512_mul_pd(a.v, b.v)}; }
+inline VecD operator/(VecD a, VecD b) { return {_mm512_div_pd(a.v, b.v)}; }
+inline VecD fmadd(VecD a, VecD b, VecD c) { return {_mm512_fmadd_pd(a.v, b.v, c.v)}; }
+inline VecD vmin(VecD a, VecD b) { return {_mm512_min_pd(a.v, b.v)}; }
+inline VecD vmax(VecD a, VecD b) { return {_mm512_max_pd(a.v, b.v)}; }
+inline VecD operator-(VecD a, VecD b) { return {_mm512_sub_pd(a.v, b.v)}; }
+inline VecD select_gt(VecD a, VecD b, VecD x, VecD y) {
+    return {_mm512_mask_blend_pd(_mm512_cmp_pd_mask(a.v, b.v, _CMP_GT_OQ), y.v, x.v)};
+}
+
+struct VecF {
+    static constexpr int width = 16;
+    __m512 v;
+
+    static VecF load(const float* p) { return {_mm512_loadu_ps(p)}; }
+    static VecF load_partial(const float* p, int n) { return {_mm512_maskz_loadu_ps(mask(n), p)}; }
+    static VecF broadcast(float x) { return {_mm512_set1_ps(x)}; }
+    void store(float* p) const { _mm512_storeu_ps(p, v); }
+    void store_partial(float* p, int n) const { _mm512_mask_storeu_ps(p, mask(n), v); }
+    static __mmask16 mask(int n) { return static_cast<__mmask16>((1u << n) - 1); }
+};
+
+inline VecF operator+(VecF a, VecF b) { return {_mm512_add_ps(a.v, b.v)}; }
+inline VecF operator-(VecF a, VecF b) { return {_mm512_sub_ps(a.v, b.v)}; }
+inline VecF operator*(VecF a, VecF b) { return {_mm512_mul_ps(a.v, b.v)}; }
+inline VecF operator/(VecF a, VecF b) { return {_mm512_div_ps(a.v, b.v)}; }
+inline VecF fmadd(VecF a, VecF b, VecF c) { return {_mm512_fmadd_ps(a.v, b.v, c.v)}; }
+inline VecF vmin(VecF a, VecF b) { return {_mm512_min_ps(a.v, b.v)}; }
+inline VecF vmax(VecF a, VecF b) { return {_mm512_max_ps(a.v, b.v)}; }
+inline VecF select_gt(VecF a, VecF b, VecF x, VecF y) {
+    return {_mm512_mask_blend_ps(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ), y.v, x.v)};
+}
+
+#elif defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define POLARIS_SIMD_NAME "avx2"
+
+struct VecD {
+    static constexpr int width = 4;
+    __m256d v;
+
+    static VecD load(const double* p) { return {_mm256_loadu_pd(p)}; }
+    static VecD load_partial(const double* p, int n) { return {_mm256_maskload_pd(p, mask(n))}; }
+    static VecD broadcast(double x) { return {_mm256_set1_pd(x)}; }
+    void store(double* p) const { _mm256_storeu_pd(p, v); }
+    void store_partial(double* p, int n) const { _mm256_maskstore_pd(p, mask(n), v); }
+    static __m256i mask(int n) { return _mm256_cmpgt_epi64(_mm256_set1_epi64x(n), _mm256_setr_epi64x(0, 1, 2, 3)); }
+};
+
+inline VecD operator+(VecD a, VecD b) { return {_mm256_add_pd(a.v, b.v)}; }
+inline VecD operator*(VecD a, VecD b) { return {_mm256_mul_pd(a.v, b.v)}; }
+inline VecD operator/(VecD a, VecD b) { return {_mm256_div_pd(a.v, b.v)}; }
+inline VecD fmadd(VecD a, VecD b, VecD c) { return {_mm256_fmadd_pd(a.v, b.v, c.v)}; }
+inline VecD vmin(VecD a, VecD b) { return {_mm256_min_pd(a.v, b.v)}; }
+inline VecD vmax(VecD a, VecD b) { return {_mm256_max_pd(a.v, b.v)}; }
+inline VecD operator-(VecD a, VecD b) { return {_mm256_sub_pd(a.v, b.v)}; }
+inline VecD select_gt(VecD a, VecD b, VecD x, VecD y) {
+    return {_mm256_blendv_pd(y.v, x.v, _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ))};
+}
+
+struct VecF {
+    static constexpr int width = 8;
+    __m256 v;
+
+    static VecF load(const float* p) { return {_mm256_loadu_ps(p)}; }
+    static VecF load_partial(const float* p, int n) { return {_mm256_maskload_ps(p, mask(n))}; }
+    static VecF broadcast(float x) { return {_mm256_set1_ps(x)}; }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+    void store_partial(float* p, int n) const { _mm256_maskstore_ps(p, mask(n), v); }
+    static __m256i mask(int n) { return _mm256_cmpgt_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)); }
+};
+
+inline VecF operator+(VecF a, VecF b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline VecF operator-(VecF a, VecF b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline VecF operator*(VecF a, VecF b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline VecF operator/(VecF a, VecF b) { return {_mm256_div_ps(a.v, b.v)}; }
+inline VecF fmadd(VecF a, VecF b, VecF c) { return {_mm256_fmadd_ps(a.v, b.v, c.v)}; }
+inline VecF vmin(VecF a, VecF b) { return {_mm256_min_ps(a.v, b.v)}; }
+inline VecF vmax(VecF a, VecF b) { return {_mm256_max_ps(a.v, b.v)}; }
+inline VecF select_gt(VecF a, VecF b, VecF x, VecF y) {
+    return {_mm256_blendv_ps(y.v, x.v, _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ))};
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define POLARIS_SIMD_NAME "sse2"
+
+struct VecD {
+    static constexpr int width = 2;
+    __m128d v;
+
+    static VecD load(const double* p) { return {_mm_loadu_pd(p)}; }
+    static VecD load_partial(const double* p, int) { return {_mm_load_sd(p)}; }  // n is 1
+    static VecD broadcast(double x) { return {_mm_set1_pd(x)}; }
+    void store(double* p) const { _mm_storeu_pd(p, v); }
+    void store_partial(double* p, int) const { _mm_store_sd(p, v); }
+};
+
+inline VecD operator+(VecD a, VecD b) { return {_mm_add_pd(a.v, b.v)}; }
+inline VecD operator*(VecD a, VecD b) { return {_mm_mul_pd(a.v, b.v)}; }
+inline VecD operator/(VecD a, VecD b) { return {_mm_div_pd(a.v, b.v)}; }
+inline VecD fmadd(VecD a, VecD b, VecD c) { return {_mm_add_pd(_mm_mul_pd(a.v, b.v), c.v)}; }
+inline VecD vmin(VecD a, VecD b) { return {_mm_min_pd(a.v, b.v)}; }
+inline VecD vmax(VecD a, VecD b) { return {_mm_max_pd(a.v, b.v)}; }
+inline VecD operator-(VecD a, VecD b) { return {_mm_sub_pd(a.v, b.v)}; }
+inline VecD select_gt(VecD a, VecD b, VecD x, VecD y) {
+    const __m128d m = _mm_cmpgt_pd(a.v, b.v);
+    return {_mm_or_pd(_mm_and_pd(m, x.v), _mm_andnot_pd(m, y.v))};
+}
+
+struct VecF {
+    static constexpr int width = 4;
+    __m128 v;
+
+    static VecF load(const float* p) { return {_mm_loadu_ps(p)}; }
+    static VecF load_partial(const float* p, int n) {
+        alignas(16) float buf[4] = {};
+        std::copy_n(p, n, buf);
+        return {_mm_load_ps(buf)};
+    }
+    static VecF broadcast(float x) { return {_mm_set1_ps(x)}; }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+    void store_partial(float* p, int n) const {
+        alignas(16) float buf[4];
+        _mm_store_ps(buf, v);
+        std::copy_n(buf, n, p);
+    }
+};
+
+inline VecF operator+(VecF a, VecF b) { return {_mm_add_ps(a.v, b.v)}; }
+inline VecF operator-(VecF a, VecF b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline VecF operator*(VecF a, VecF b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline VecF operator/(VecF a, VecF b) { return {_mm_div_ps(a.v, b.v)}; }
+inline VecF fmadd(VecF a, VecF b, VecF c) { return {_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v)}; }
+inline VecF vmin(VecF a, VecF b) { return {_mm_min_ps(a.v, b.v)}; }
+inline VecF vmax(VecF a, VecF b) { return {_mm_max_ps(a.v, b.v)}; }
+inline VecF select_gt(VecF a, VecF b, VecF x, VecF y) {
+    const __m128 m = _mm_cmpgt_ps(a.v, b.v);
+    return {_mm_or_ps(_mm_and_ps(m, x.v), _mm_andnot_ps(m, y.v))};
+}
+
+#else
+#define POLARIS_SIMD_NAME "scalar"
+
+struct VecD {
+    static constexpr int width = 1;
+    double v;
+
+    static VecD load(const double* p) { return {*p}; }
+    static VecD load_partial(const double* p, int) { return {*p}; }
+    static VecD broadcast(double x) { return {x}; }
+    void store(double* p) const { *p = v; }
+    void store_partial(double* p, int) const { *p = v; }
+};
+
+inline VecD operator+(VecD a, VecD b) { return {a.v + b.v}; }
+inline VecD operator*(VecD a, VecD b) { return {a.v * b.v}; }
+inline VecD operator/(VecD a, VecD b) { return {a.v / b.v}; }
+inline VecD fmadd(VecD a, VecD b, VecD c) { return {a.v * b.v + c.v}; }
+inline VecD vmin(VecD a, VecD b) { return {std::min(a.v, b.v)}; }
+inline VecD vmax(VecD a, VecD b) { return {std::max(a.v, b.v)}; }
+inline VecD operator-(VecD a, VecD b) { return {a.v - b.v}; }
+inline VecD select_gt(VecD a, VecD b, VecD x, VecD y) { return a.v > b.v ? x : y; }
+
+struct VecF {
+    static constexpr int width = 1;
+    float v;
+
+    static VecF load(const float* p) { return {*p}; }
+    static VecF load_partial(const float* p, int) { return {*p}; }
+    static VecF broadcast(float x) { return {x}; }
+    void store(float* p) const { *p = v; }
+    void store_partial(float* p, int) const { *p = v; }
+};
+
+inline VecF operator+(VecF a, VecF b) { return {a.v + b.v}; }
+inline VecF operator-(VecF a, VecF b) { return {a.v - b.v}; }
+inline VecF operator*(VecF a, VecF b) { return {a.v * b.v}; }
+inline VecF operator/(VecF a, VecF b) { return {a.v / b.v}; }
+inline VecF fmadd(VecF a, VecF b, VecF c) { return {a.v * b.v + c.v}; }
+inline VecF vmin(VecF a, VecF b) { return {std::min(a.v, b.v)}; }
+inline VecF vmax(VecF a, VecF b) { return {std::max(a.v, b.v)}; }
+inline VecF select_gt(VecF a, VecF b, VecF x, VecF y) { return a.v > b.v ? x : y; }
+
+#endif
+
+// Vector of Real, the type the simulation kernels run on
+using VecR = std::conditional_t<std::is_same_v<Real, float>, VecF, VecD>;
+
+// Scalar overloads so the same kernel body serves remainder elements
+inline double fmadd(double a, double b, double c) { return a * b + c; }
+inline double vmin(double a, double b) { return std::min(a, b); }
+inline double vmax(double a, double b) { return std::max(a, b); }
+inline float fmadd(float a, float b, float c) { return a * b + c; }
+inline float vmin(float a, float b) { return std::min(a, b); }
+inline float vmax(float a, float b) { return std::max(a, b); }
+
+/**
+ * @brief Branch-free rational approximation of tanh.
+ *
+ * x * P(x^2) / Q(x^2) on [-7.9, 7.9] (the same minimax fit Eigen uses),
+ * saturating to +-1 outside. Absolute error is below 1e-6, far under the
+ * noise that mutation adds to the networks, and unlike std::tanh it
+ * vectorizes.
+ */
+template <class V>
+inline V tanh_approx(V x) {
+    auto c = [](double k) {
+        if constexpr (std::is_floating_point_v<V>) return static_cast<V>(k);
+        else return V::broadcast(k);
+    };
+
+    x = vmin(vmax(x, c(-7.90531110763549805)), c(7.90531110763549805));
+    const V x2 = x * x;
+
+    V p = fmadd(x2, c(-2.76076847742355e-16), c(2.00018790482477e-13));
+    p = fmadd(x2, p, c(-8.60467152213735e-11));
+    p = fmadd(x2, p, c(5.12229709037114e-08));
+    p = fmadd(x2, p, c(1.48572235717979e-05));
+    p = fmadd(x2, p, c(6.37261928875436e-04));
+    p = fmadd(x2, p, c(4.89352455891786e-03));
+    p = x * p;
+
+    V q = fmadd(x2, c(1.19825839466702e-06), c(1.18534705686654e-04));
+    q = fmadd(x2, q, c(2.26843463243900e-03));
+    q = fmadd(x2, q, c(4.89352518554385e-03));
+
+    return p / q;
+}
@@ -1,8 +1,11 @@
 #include "simulon_env.hpp"
+#include "simulon_vec_env.hpp"
 #include "neural_network.hpp"
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
-#include <SDL2/SDL.h>
+#include <cstring>
+#include <stdexcept>
 #include <vector>
 #include <string>
 
@@ -11,65 +14,123 @@
 
 namespace py = pybind11;
 
-SimulonEnv::SimulonEnv(int nAgents, unsigned seed, double dt)
-    : config_(SimulationConfig::create_default()),
-      world_(config_, seed), 
-      dt_(dt) {
-    config_.num_agents = nAgents;
-    config_.seed = seed;
-    config_.dt = dt;
-}
+namespace {
 
-void SimulonEnv::step() {
-    world_.update(dt_);
+// The world reads its config on construction, so it must be complete first
+SimulationConfig make_config(int nAgents, unsigned seed, double dt) {
+    SimulationConfig config = SimulationConfig::create_default();
+    config.num_agents = nAgents;
+    config.seed = seed;
+    config.dt = dt;
+    return config;
 }
 
-std::vector<Agent> SimulonEnv::get_state() const {
-    return world_.agents;
+// Copy a row-major engine buffer into a new numpy array
+template <class T>
+py::array_t<T> to_numpy(const T* data, std::vector<py::ssize_t> shape) {
+    py::array_t<T> array(shape);
+    std::memcpy(array.mutable_data(), data, array.size() * sizeof(T));
+    return array;
 }
 
-// ✅ FIXED VERSION of render_frame
-void SimulonEnv::render_frame(const std::string& filename, int size) const {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        throw std::runtime_error("SDL initialization failed");
+// Interleave two engine columns into an (n, 2) numpy array
+template <class T>
+py::array_t<T> pair_to_numpy(const std::vector<T>& x, const std::vector<T>& y) {
+    const size_t n = x.size();
+    py::array_t<T> array({static_cast<py::ssize_t>(n), py::ssize_t{2}});
+    T* out = array.mutable_data();
+    for (size_t i = 0; i < n; ++i) {
+        out[2 * i] = x[i];
+        out[2 * i + 1] = y[i];
     }
+    return array;
+}
 
-    SDL_Window* win = SDL_CreateWindow("offscreen",
-        SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-        size, size, SDL_WINDOW_HIDDEN);
-    SDL_Renderer* renderer = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED);
+// The agent columns of a world as numpy arrays. Each column is copied in
+// bulk: a step can append births and reallocate the engine's vectors, so
+// arrays aliasing them could be left pointing at freed memory. Real columns
+// come out as float64, or float32 in a POLARIS_FLOAT build.
+py::dict state_arrays(const World& world) {
+    const AgentStore& agents = world.agents;
+    const py::ssize_t n = static_cast<py::ssize_t>(agents.size());
+    py::dict state;
+    state["id"] = to_numpy(agents.id.data(), {n});
+    state["pos"] = pair_to_numpy(agents.pos_x, agents.pos_y);
+    state["vel"] = pair_to_numpy(agents.vel_x, agents.vel_y);
+    state["energy"] = to_numpy(agents.energy.data(), {n});
+    state["age"] = to_numpy(agents.age.data(), {n});
+    state["generation"] = to_numpy(agents.generation.data(), {n});
+
+    // Stored as 0/1 bytes, so the column copies straight into bool
+    state["predator"] = to_numpy(reinterpret_cast<const bool*>(agents.predator.data()), {n});
+    return state;
+}
 
-    // clear background
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderClear(renderer);
+// Read-only view of a frame buffer. The capsule holds a reference to the
+// buffer, which the env replaces instead of resizing, so the view stays valid
+// however long it is kept; it shows each later render() of the same size.
+py::array frame_view(std::shared_ptr<const Rasterizer> frame) {
+    const Rasterizer* raster = frame.get();
+    py::capsule owner(new std::shared_ptr<const Rasterizer>(std::move(frame)), [](void* p) {
+        delete static_cast<std::shared_ptr<const Rasterizer>*>(p);
+    });
+    py::array_t<uint8_t> view({raster->height(), raster->width(), 4},
+                              {raster->stride(), 4, 1}, raster->pixels(), owner);
+    view.attr("setflags")(py::arg("write") = false);
+    return view;
+}
 
-    const double scale = size / (2.0 * world_.boundary);
-    for (auto& a : world_.agents) {
-        int px = static_cast<int>((a.pos.x + world_.boundary) * scale);
-        int py = static_cast<int>((a.pos.y + world_.boundary) * scale);
-        SDL_Rect r{px - 4, py - 4, 8, 8};
+py::array_t<bool> dones_to_numpy(const SimulonVecEnv& env) {
+    py::array_t<bool> array(env.num_envs());
+    bool* out = array.mutable_data();
+    for (int i = 0; i < env.num_envs(); ++i) out[i] = env.dones()[i] != 0;
+    return array;
+}
 
-        if (a.predator) SDL_SetRenderDrawColor(renderer, 255, 50, 50, 255);
-        else             SDL_SetRenderDrawColor(renderer, 50, 200, 255, 255);
+}  // namespace
 
-        SDL_RenderFillRect(renderer, &r);
-    }
+SimulonEnv::SimulonEnv(int nAgents, unsigned seed, double dt)
+    : config_(make_config(nAgents, seed, dt)),
+      world_(config_, seed), 
+      dt_(dt),
+      raster_(std::make_shared<Rasterizer>()) {}
 
-    SDL_RenderPresent(renderer);
+void SimulonEnv::step() {
+    world_.update(dt_);
+}
 
-    // read pixels from renderer
-    std::vector<unsigned char> pixels(size * size * 4);
-    SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_ABGR8888,
-                         pixels.data(), size * 4);
+std::vector<Agent> SimulonEnv::get_state() const {
+    return world_.agents.materialize();
+}
+
+const Rasterizer& SimulonEnv::render(int size) {
+    if (size <= 0) throw std::invalid_argument("render size must be positive");
+    if (raster_->width() != size || raster_->height() != size) raster_ = std::make_shared<Rasterizer>(size, size);
+    raster_->draw(world_);
+    return *raster_;
+}
 
-    // write PNG
-    if (!stbi_write_png(filename.c_str(), size, size, 4, pixels.data(), size * 4)) {
+void SimulonEnv::render_frame(const std::string& filename, int size) {
+    const Rasterizer& frame = render(size);
+    if (!stbi_write_png(filename.c_str(), frame.width(), frame.height(), 4, frame.pixels(), frame.stride())) {
         throw std::runtime_error("Failed to write PNG file");
     }
+}
+
+void SimulonEnv::start_video(const std::string& filename, int size, int fps) {
+    if (size <= 0) throw std::invalid_argument("video size must be positive");
+    if (!video_.open(filename, size, size, fps)) {
+        throw std::runtime_error("Failed to open video file " + filename);
+    }
+}
+
+void SimulonEnv::record_frame() {
+    if (!video_.is_open()) throw std::runtime_error("No video is being recorded (call start_video first)");
+    if (!video_.write(render(video_.width()))) throw std::runtime_error("Failed to write video frame");
+}
 
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(win);
-    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+void SimulonEnv::stop_video() {
+    video_.close();
 }
 
 // 🔗 Python binding
@@ -81,15 +142,74 @@ PYBIND11_MODULE(simulon, m) {
     .def_readonly("y", &Vec2::y);
 
 py::class_<Agent>(m, "Agent")
+    .def_readonly("id", &Agent::id)
     .def_readonly("pos", &Agent::pos)
     .def_readonly("vel", &Agent::vel)
-    .def_readonly("predator", &Agent::predator);
+    .def_readonly("predator", &Agent::predator)
+    .def_readonly("energy", &Agent::energy)
+    .def_readonly("age", &Agent::age)
+    .def_readonly("kills", &Agent::kills)
+    .def_readonly("generation", &Agent::generation);
 
     py::class_<SimulonEnv>(m, "SimulonEnv")
         .def(py::init<int, unsigned, double>(),
              py::arg("n_agents")=10, py::arg("seed")=42, py::arg("dt")=0.1)
         .def("step", &SimulonEnv::step)
         .def("get_state", &SimulonEnv::get_state)
+        .def("get_state_arrays", [](const SimulonEnv& env) {
+            return state_arrays(env.world());
+        }, "Dict of numpy arrays (id, pos, vel, energy, predator, age, generation), one row per agent")
+        .def("render", [](SimulonEnv& env, int size) {
+            env.render(size);
+            return frame_view(env.frame_buffer());
+        }, py::arg("size") = 600,
+           "Draw the current state and return it as a read-only (size, size, 4) uint8 RGBA view "
+           "of the env's frame buffer (overwritten by the next render of the same size)")
         .def("render_frame", &SimulonEnv::render_frame,
-             py::arg("filename"), py::arg("size") = 600);
+             py::arg("filename"), py::arg("size") = 600)
+        .def("start_video", &SimulonEnv::start_video,
+             py::arg("filename"), py::arg("size") = 600, py::arg("fps") = 30,
+             "Start streaming frames to an uncompressed .y4m video")
+        .def("record_frame", &SimulonEnv::record_frame, "Render the current state and append it to the video")
+        .def("stop_video", &SimulonEnv::stop_video);
+
+    // Many worlds stepped in parallel with the GIL released
+    py::class_<SimulonVecEnv>(m, "SimulonVecEnv")
+        .def(py::init<int, int, unsigned, double, int, int>(),
+             py::arg("num_envs"), py::arg("n_agents") = 10, py::arg("seed") = 42,
+             py::arg("dt") = 0.1, py::arg("max_episode_steps") = 1000, py::arg("num_threads") = 0)
+        .def("reset", [](SimulonVecEnv& env) {
+            {
+                py::gil_scoped_release release;
+                env.reset();
+            }
+            return to_numpy(env.observations(), {env.num_envs(), SimulonVecEnv::OBS_SIZE});
+        }, "Start a new episode in every world and return the observations")
+        .def("step", [](SimulonVecEnv& env) {
+            {
+                py::gil_scoped_release release;
+                env.step();
+            }
+            return py::make_tuple(
+                to_numpy(env.observations(), {env.num_envs(), SimulonVecEnv::OBS_SIZE}),
+                to_numpy(env.rewards(), {env.num_envs()}),
+                dones_to_numpy(env));
+        }, "Step every world; returns (observations, rewards, dones). Finished worlds are reset.")
+        .def("terminal_observations", [](const SimulonVecEnv& env) {
+            return to_numpy(env.terminal_observations(), {env.num_envs(), SimulonVecEnv::OBS_SIZE});
+        }, "Last observation of each world whose episode ended on the latest step")
+        .def("episode_lengths", [](const SimulonVecEnv& env) {
+            return to_numpy(env.episode_lengths(), {env.num_envs()});
+        }, "Length of the episode that ended on the latest step (0 where none ended)")
+        .def("get_state", [](const SimulonVecEnv& env, int index) {
+            if (index < 0 || index >= env.num_envs()) throw py::index_error("env index out of range");
+            return env.world(index).agents.materialize();
+        }, py::arg("env_index"))
+        .def("get_state_arrays", [](const SimulonVecEnv& env, int index) {
+            if (index < 0 || index >= env.num_envs()) throw py::index_error("env index out of range");
+            return state_arrays(env.world(index));
+        }, py::arg("env_index"), "Agent column arrays for one world, as SimulonEnv.get_state_arrays")
+        .def_property_readonly("num_envs", &SimulonVecEnv::num_envs)
+        .def_property_readonly_static("observation_size",
+            [](py::object) { return SimulonVecEnv::OBS_SIZE; });
 }
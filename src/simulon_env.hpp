@@ -1,15 +1,32 @@
 #pragma once
 #include "world.hpp"
 #include "config.hpp"
+#include "rasterizer.hpp"
+#include <memory>
 #include <string>
 
 class SimulonEnv {
     SimulationConfig config_;
     World world_;
     double dt_;
+    std::shared_ptr<Rasterizer> raster_;  // Replaced, not resized, when the frame size changes
+    Y4mWriter video_;
 public:
     SimulonEnv(int nAgents = 10, unsigned seed = 42, double dt = 0.1);
     void step();
     std::vector<Agent> get_state() const;
-    void render_frame(const std::string& filename, int size = 600) const;  // NEW
+    const World& world() const { return world_; }
+
+    // Draw the current state into the env's frame buffer (size x size RGBA).
+    // A new size gets a new buffer, so earlier buffers are never reallocated
+    // under a holder of frame_buffer().
+    const Rasterizer& render(int size = 600);
+    std::shared_ptr<const Rasterizer> frame_buffer() const { return raster_; }
+    void render_frame(const std::string& filename, int size = 600);
+
+    // Frame-sequence export: each record_frame() renders at the size the
+    // video was started with and appends the frame
+    void start_video(const std::string& filename, int size = 600, int fps = 30);
+    void record_frame();
+    void stop_video();
 };
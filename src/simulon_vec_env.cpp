@@ -0,0 +1,101 @@
+#include "simulon_vec_env.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+
+SimulonVecEnv::SimulonVecEnv(int num_envs, int n_agents, unsigned seed, double dt,
+                             int max_episode_steps, int num_threads)
+    : seed_(seed),
+      n_agents_(std::max(n_agents, 0)),
+      dt_(dt),
+      max_episode_steps_(std::max(max_episode_steps, 1)) {
+    num_envs = std::max(num_envs, 1);
+    pool_ = std::make_unique<ThreadPool>(num_threads);
+
+    envs_.reserve(num_envs);
+    for (int i = 0; i < num_envs; ++i) {
+        auto env = std::make_unique<Env>();
+        env->config = SimulationConfig::create_default();
+        env->config.num_agents = n_agents_;
+        env->config.dt = dt_;
+        env->config.enable_stats = false;
+        env->config.num_threads = 1;  // Parallelism comes from running worlds side by side
+        envs_.push_back(std::move(env));
+    }
+
+    obs_.resize(static_cast<size_t>(num_envs) * OBS_SIZE);
+    terminal_obs_.resize(obs_.size());
+    rewards_.resize(num_envs);
+    dones_.resize(num_envs);
+    episode_lengths_.resize(num_envs);
+
+    reset();
+}
+
+// Defined here where ThreadPool is complete
+SimulonVecEnv::~SimulonVecEnv() = default;
+
+void SimulonVecEnv::reset_env(size_t i) {
+    Env& env = *envs_[i];
+
+    // Distinct, reproducible seed for every (world, episode) pair
+    const unsigned episode_seed = seed_ + static_cast<unsigned>(i)
+        + static_cast<unsigned>(env.episode) * static_cast<unsigned>(envs_.size());
+    env.config.seed = episode_seed;
+    env.world = std::make_unique<World>(env.config, episode_seed);
+    env.steps = 0;
+    env.episode++;
+}
+
+void SimulonVecEnv::observe(size_t i, double* out) const {
+    const Env& env = *envs_[i];
+    const PopulationStats& population = env.world->population;
+    const int prey = population.prey();
+    const int predators = population.predators();
+
+    const double population_scale = n_agents_ > 0 ? 1.0 / n_agents_ : 1.0;
+    const double energy_scale = env.config.max_energy > 0.0 ? 1.0 / env.config.max_energy : 1.0;
+    out[0] = prey * population_scale;
+    out[1] = predators * population_scale;
+    out[2] = population.avg_energy(false) * energy_scale;
+    out[3] = population.avg_energy(true) * energy_scale;
+    out[4] = population.avg_generation();
+    out[5] = static_cast<double>(env.steps) / max_episode_steps_;
+}
+
+void SimulonVecEnv::reset() {
+    pool_->parallel_for(envs_.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            reset_env(i);
+            observe(i, &obs_[i * OBS_SIZE]);
+            rewards_[i] = 0.0;
+            dones_[i] = 0;
+            episode_lengths_[i] = 0;
+        }
+    }, 1);
+}
+
+void SimulonVecEnv::step() {
+    // One world per task; each task touches only its own world and rows
+    pool_->parallel_for(envs_.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Env& env = *envs_[i];
+            env.world->update(dt_);
+            env.steps++;
+
+            double* row = &obs_[i * OBS_SIZE];
+            observe(i, row);
+
+            const bool both_alive = row[0] > 0.0 && row[1] > 0.0;
+            const bool done = !both_alive || env.steps >= max_episode_steps_;
+            rewards_[i] = both_alive ? 1.0 : 0.0;
+            dones_[i] = done ? 1 : 0;
+            episode_lengths_[i] = done ? env.steps : 0;
+
+            if (done) {
+                std::copy(row, row + OBS_SIZE, &terminal_obs_[i * OBS_SIZE]);
+                reset_env(i);
+                observe(i, row);
+            }
+        }
+    }, 1);
+}
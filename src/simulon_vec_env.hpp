@@ -0,0 +1,79 @@
+#pragma once
+#include "world.hpp"
+#include "config.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * @brief A batch of independent worlds stepped together, for RL training.
+ *
+ * Every world runs single-threaded and the batch is spread across a shared
+ * thread pool, so step() costs roughly one world step per core. Results are
+ * kept in contiguous row-major buffers (one row per world) that the Python
+ * binding copies out as numpy arrays.
+ *
+ * Each world is an episode. The per-step reward is 1 while both predators and
+ * prey survive and 0 otherwise. An episode ends when either species dies out
+ * or after max_episode_steps steps. Finished worlds are reset automatically
+ * with a fresh seed. Their last observation is kept in
+ * terminal_observations(), and observations() already holds the first
+ * observation of the new episode.
+ *
+ * Observation row (OBS_SIZE values):
+ *   [prey / n_agents, predators / n_agents, mean prey energy / max_energy,
+ *    mean predator energy / max_energy, mean generation, step / max_episode_steps]
+ */
+class SimulonVecEnv {
+public:
+    static constexpr int OBS_SIZE = 6;
+
+    // num_threads <= 0 uses every hardware thread
+    SimulonVecEnv(int num_envs, int n_agents = 10, unsigned seed = 42, double dt = 0.1,
+                  int max_episode_steps = 1000, int num_threads = 0);
+    ~SimulonVecEnv();
+
+    // Start a new episode in every world
+    void reset();
+
+    // Advance every world by one step, auto-resetting finished episodes
+    void step();
+
+    [[nodiscard]] int num_envs() const { return static_cast<int>(envs_.size()); }
+    [[nodiscard]] const World& world(int env) const { return *envs_[env]->world; }
+
+    // num_envs x OBS_SIZE
+    [[nodiscard]] const double* observations() const { return obs_.data(); }
+    [[nodiscard]] const double* terminal_observations() const { return terminal_obs_.data(); }
+
+    // num_envs entries, refreshed by step()
+    [[nodiscard]] const double* rewards() const { return rewards_.data(); }
+    [[nodiscard]] const uint8_t* dones() const { return dones_.data(); }
+    [[nodiscard]] const int* episode_lengths() const { return episode_lengths_.data(); }
+
+private:
+    struct Env {
+        SimulationConfig config;  // World keeps a pointer to this
+        std::unique_ptr<World> world;
+        int steps = 0;
+        int episode = 0;
+    };
+
+    std::vector<std::unique_ptr<Env>> envs_;
+    std::unique_ptr<ThreadPool> pool_;
+    unsigned seed_;
+    int n_agents_;
+    double dt_;
+    int max_episode_steps_;
+
+    std::vector<double> obs_;
+    std::vector<double> terminal_obs_;
+    std::vector<double> rewards_;
+    std::vector<uint8_t> dones_;
+    std::vector<int> episode_lengths_;  // Length of the episode that just ended (0 if none)
+
+    void reset_env(size_t i);
+    void observe(size_t i, double* out) const;
+};
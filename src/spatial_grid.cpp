@@ -2,74 +2,443 @@
 #include <cmath>
 #include <algorithm>
 
-SpatialGrid::SpatialGrid(double world_size, int grid_cells)
-    : world_size_(world_size), grid_cells_(grid_cells) {
+SpatialGrid::SpatialGrid(double world_size, int grid_cells, bool wrap)
+    : world_size_(world_size), grid_cells_(std::max(grid_cells, 1)), wrap_(wrap) {
     cell_size_ = (2.0 * world_size_) / grid_cells_;
-    cells_.resize(grid_cells_ * grid_cells_);
+    period_ = static_cast<Real>(2.0 * world_size_);
+    half_period_ = static_cast<Real>(world_size_);
+    cell_start_.assign(1, 0u);
+    rebuild_index();
 }
 
-void SpatialGrid::clear() {
-    for (auto& cell : cells_) {
-        cell.clear();
+int SpatialGrid::lattice(double c) const {
+    const double g = std::clamp((c + world_size_) / cell_size_, -MAX_COORD, MAX_COORD);
+    int gi = static_cast<int>(g);
+    return g < gi ? gi - 1 : gi;  // Floor
+}
+
+int SpatialGrid::wrap_coord(int g) const {
+    g %= grid_cells_;
+    return g < 0 ? g + grid_cells_ : g;
+}
+
+// The world edge is closed ([-world_size, world_size]), so a coordinate lying
+// exactly on the upper edge belongs to the last cell rather than to the next
+// one; in wrap mode it is the lower edge again
+uint64_t SpatialGrid::cell_of(double x, double y) const {
+    if (std::isnan(x) || std::isnan(y)) return NO_CELL;
+    int gx = lattice(x);
+    int gy = lattice(y);
+    if (wrap_) {
+        gx = wrap_coord(gx);
+        gy = wrap_coord(gy);
+    } else {
+        if (gx == grid_cells_ && x <= world_size_) gx--;
+        if (gy == grid_cells_ && y <= world_size_) gy--;
+    }
+    return to_key(gx, gy);
+}
+
+uint32_t SpatialGrid::find(uint64_t key) const {
+    if (dense_) {
+        const int gx = key_x(key), gy = key_y(key);
+        if (gx < min_gx_ || gx > max_gx_ || gy < min_gy_ || gy > max_gy_) return NO_SLOT;
+        const size_t c = static_cast<size_t>(gy - min_gy_) * box_width_ + (gx - min_gx_);
+        return first_slot_[c + 1] > first_slot_[c] ? first_slot_[c] : NO_SLOT;
+    }
+
+    // Fibonacci hashing: the top bits of key * 2^64 / phi
+    const size_t mask = table_.size() - 1;
+    for (size_t h = (key * 0x9E3779B97F4A7C15ull) >> hash_shift_; ; h = (h + 1) & mask) {
+        const Bucket& b = table_[h];
+        if (b.key == key) return b.slot;
+        if (b.key == NO_CELL) return NO_SLOT;
+    }
+}
+
+uint32_t SpatialGrid::insert(uint64_t key, uint32_t slot) {
+    // Keep the table at most half full
+    if (2 * (cell_keys_.size() + 1) > table_.size()) {
+        std::vector<Bucket> old;
+        old.swap(table_);
+        reset_table(old.size());
+        for (const Bucket& b : old) {
+            if (b.key != NO_CELL) insert(b.key, b.slot);
+        }
+    }
+
+    const size_t mask = table_.size() - 1;
+    for (size_t h = (key * 0x9E3779B97F4A7C15ull) >> hash_shift_; ; h = (h + 1) & mask) {
+        Bucket& b = table_[h];
+        if (b.key == key) return b.slot;
+        if (b.key == NO_CELL) {
+            b = {key, slot};
+            return slot;
+        }
+    }
+}
+
+// Empty table with room for cells occupied cells
+void SpatialGrid::reset_table(size_t cells) {
+    size_t size = 16;
+    int bits = 4;
+    while (size < 2 * cells) {
+        size *= 2;
+        bits++;
+    }
+    table_.assign(size, {NO_CELL, NO_SLOT});
+    if (table_.capacity() > 2 * size) table_.shrink_to_fit();  // The world emptied out
+    hash_shift_ = 64 - bits;
+}
+
+void SpatialGrid::update_bounds() {
+    min_gx_ = min_gy_ = 0;
+    max_gx_ = max_gy_ = -1;
+    if (cell_keys_.empty()) return;
+
+    // Rows are sorted; columns need a scan
+    min_gy_ = key_y(cell_keys_.front());
+    max_gy_ = key_y(cell_keys_.back());
+    min_gx_ = std::numeric_limits<int>::max();
+    max_gx_ = std::numeric_limits<int>::min();
+    for (uint64_t key : cell_keys_) {
+        min_gx_ = std::min(min_gx_, key_x(key));
+        max_gx_ = std::max(max_gx_, key_x(key));
     }
 }
 
-int SpatialGrid::to_grid_x(double x) const {
-    return static_cast<int>((x + world_size_) / cell_size_);
+void SpatialGrid::rebuild_index() {
+    update_bounds();
+    const size_t m = cell_keys_.size();
+    const size_t width = static_cast<size_t>(static_cast<int64_t>(max_gx_) - min_gx_ + 1);
+    const size_t height = static_cast<size_t>(static_cast<int64_t>(max_gy_) - min_gy_ + 1);
+    dense_ = fits_dense(width * height, m);
+
+    if (dense_) {
+        // Walk the box and the sorted keys together
+        box_width_ = width;
+        first_slot_.resize(width * height + 1);
+        uint32_t slot = 0;
+        size_t c = 0;
+        for (int gy = min_gy_; gy <= max_gy_; ++gy) {
+            for (int gx = min_gx_; gx <= max_gx_; ++gx, ++c) {
+                first_slot_[c] = slot;
+                if (slot < m && cell_keys_[slot] == to_key(gx, gy)) slot++;
+            }
+        }
+        first_slot_[c] = slot;
+        first_agent_.resize(c + 1);
+        table_.clear();
+        table_.shrink_to_fit();
+        refresh_offsets();
+        return;
+    }
+
+    reset_table(m);
+    const size_t mask = table_.size() - 1;
+    for (size_t s = 0; s < m; ++s) {
+        size_t h = (cell_keys_[s] * 0x9E3779B97F4A7C15ull) >> hash_shift_;
+        while (table_[h].key != NO_CELL) h = (h + 1) & mask;
+        table_[h] = {cell_keys_[s], static_cast<uint32_t>(s)};
+    }
+    first_slot_.clear();
+    first_slot_.shrink_to_fit();
+    first_agent_.clear();
+    first_agent_.shrink_to_fit();
 }
 
-int SpatialGrid::to_grid_y(double y) const {
-    return static_cast<int>((y + world_size_) / cell_size_);
+void SpatialGrid::refresh_offsets() {
+    if (!dense_) return;
+    for (size_t c = 0; c < first_slot_.size(); ++c) first_agent_[c] = cell_start_[first_slot_[c]];
 }
 
-int SpatialGrid::to_cell_index(int gx, int gy) const {
-    return gy * grid_cells_ + gx;
+uint32_t SpatialGrid::first_in_row(int gy, int gx0, int gx1) const {
+    // A short span is cheaper to probe cell by cell than to search
+    if (gx1 - gx0 < 8) {
+        for (int gx = gx0; gx <= gx1; ++gx) {
+            const uint32_t slot = find(to_key(gx, gy));
+            if (slot != NO_SLOT) return slot;
+        }
+        return NO_SLOT;
+    }
+    const auto it = std::lower_bound(cell_keys_.begin(), cell_keys_.end(), to_key(gx0, gy));
+    if (it == cell_keys_.end() || *it > to_key(gx1, gy)) return NO_SLOT;
+    return static_cast<uint32_t>(it - cell_keys_.begin());
 }
 
-bool SpatialGrid::in_bounds(int gx, int gy) const {
-    return gx >= 0 && gx < grid_cells_ && gy >= 0 && gy < grid_cells_;
+void SpatialGrid::build_csr() {
+    const size_t n = agent_cell_.size();
+
+    // Bounding box of the indexed agents' cells
+    int x0 = std::numeric_limits<int>::max(), x1 = std::numeric_limits<int>::min();
+    int y0 = std::numeric_limits<int>::max(), y1 = std::numeric_limits<int>::min();
+    size_t indexed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t key = agent_cell_[i];
+        if (key == NO_CELL) continue;
+        x0 = std::min(x0, key_x(key));
+        x1 = std::max(x1, key_x(key));
+        y0 = std::min(y0, key_y(key));
+        y1 = std::max(y1, key_y(key));
+        indexed++;
+    }
+    if (indexed == 0) {
+        cell_keys_.clear();
+        cell_start_.assign(1, 0u);
+        indices_.clear();
+        rebuild_index();
+        return;
+    }
+
+    const size_t width = static_cast<size_t>(static_cast<int64_t>(x1) - x0 + 1);
+    const size_t height = static_cast<size_t>(static_cast<int64_t>(y1) - y0 + 1);
+    if (fits_dense(width * height, indexed) && build_dense(x0, y0, width, height)) return;
+    build_sparse();
 }
 
-void SpatialGrid::insert(size_t agent_idx, const Vec2& pos) {
-    int gx = to_grid_x(pos.x);
-    int gy = to_grid_y(pos.y);
-    
-    if (in_bounds(gx, gy)) {
-        cells_[to_cell_index(gx, gy)].push_back(agent_idx);
+// Counting sort over the bounding box; false (and nothing built) if the
+// occupied cells turn out to be too scattered for a dense index
+bool SpatialGrid::build_dense(int x0, int y0, size_t width, size_t height) {
+    const size_t n = agent_cell_.size();
+    const size_t area = width * height;
+    auto box_cell = [&](uint64_t key) {
+        return static_cast<size_t>(key_y(key) - y0) * width + (key_x(key) - x0);
+    };
+
+    // Pass 1: histogram of agents per cell (shifted by one for the prefix sum)
+    first_agent_.assign(area + 1, 0u);
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t key = agent_cell_[i];
+        if (key != NO_CELL) first_agent_[box_cell(key) + 1]++;
     }
+    size_t m = 0;
+    for (size_t c = 1; c <= area; ++c) m += first_agent_[c] != 0;
+    if (!fits_dense(area, m)) return false;
+
+    // Prefix sums, numbering the occupied cells on the way
+    cell_keys_.resize(m);
+    cell_start_.resize(m + 1);
+    first_slot_.resize(area + 1);
+    uint32_t sum = 0, slot = 0;
+    size_t c = 0;
+    for (size_t row = 0; row < height; ++row) {
+        for (size_t col = 0; col < width; ++col, ++c) {
+            const uint32_t count = first_agent_[c + 1];
+            first_slot_[c] = slot;
+            first_agent_[c] = sum;
+            if (count == 0) continue;
+            cell_keys_[slot] = to_key(x0 + static_cast<int>(col), y0 + static_cast<int>(row));
+            cell_start_[slot++] = sum;
+            sum += count;
+        }
+    }
+    first_slot_[area] = slot;
+    first_agent_[area] = sum;
+    cell_start_[m] = sum;
+
+    // Pass 2: stable scatter, so each cell lists its agents in index order
+    indices_.resize(sum);
+    cursor_.assign(first_agent_.begin(), first_agent_.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t key = agent_cell_[i];
+        if (key != NO_CELL) indices_[cursor_[box_cell(key)]++] = static_cast<uint32_t>(i);
+    }
+
+    dense_ = true;
+    box_width_ = width;
+    min_gx_ = x0, max_gx_ = x0 + static_cast<int>(width) - 1;
+    min_gy_ = y0, max_gy_ = y0 + static_cast<int>(height) - 1;
+    if (!table_.empty()) {
+        table_.clear();
+        table_.shrink_to_fit();
+    }
+    return true;
 }
 
-void SpatialGrid::query_radius(const Vec2& pos, double radius, 
-                               std::function<void(size_t)> callback) const {
-    int center_gx = to_grid_x(pos.x);
-    int center_gy = to_grid_y(pos.y);
-    
-    // Check how many cells we need to search
-    int cell_radius = static_cast<int>(std::ceil(radius / cell_size_)) + 1;
-    
-    for (int dy = -cell_radius; dy <= cell_radius; ++dy) {
-        for (int dx = -cell_radius; dx <= cell_radius; ++dx) {
-            int gx = center_gx + dx;
-            int gy = center_gy + dy;
-            
-            if (!in_bounds(gx, gy)) continue;
-            
-            const auto& cell = cells_[to_cell_index(gx, gy)];
-            for (size_t idx : cell) {
-                callback(idx);
+void SpatialGrid::build_sparse() {
+    const size_t n = agent_cell_.size();
+
+    // Pass 1: number the occupied cells in order of discovery and count
+    // their agents. Neighbouring agents often share a cell, so the last
+    // lookup is remembered.
+    dense_ = false;
+    reset_table(cell_keys_.size());
+    cell_keys_.clear();
+    counts_.clear();
+    agent_slot_.resize(n);
+    uint64_t last_key = NO_CELL;
+    uint32_t last_slot = NO_SLOT;
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t key = agent_cell_[i];
+        if (key == NO_CELL) {
+            agent_slot_[i] = NO_SLOT;
+            continue;
+        }
+        if (key != last_key) {
+            last_key = key;
+            last_slot = insert(key, static_cast<uint32_t>(cell_keys_.size()));
+            if (last_slot == cell_keys_.size()) {
+                cell_keys_.push_back(key);
+                counts_.push_back(0);
             }
         }
+        counts_[last_slot]++;
+        agent_slot_[i] = last_slot;
+    }
+    const size_t m = cell_keys_.size();
+
+    // Pass 2: sort the cells by key and renumber them
+    order_.resize(m);
+    for (size_t s = 0; s < m; ++s) order_[s] = static_cast<uint32_t>(s);
+    std::sort(order_.begin(), order_.end(), [&](uint32_t a, uint32_t b) { return cell_keys_[a] < cell_keys_[b]; });
+
+    rank_.resize(m);
+    sorted_keys_.resize(m);
+    cell_start_.resize(m + 1);
+    cell_start_[0] = 0;
+    for (size_t r = 0; r < m; ++r) {
+        rank_[order_[r]] = static_cast<uint32_t>(r);
+        sorted_keys_[r] = cell_keys_[order_[r]];
+        cell_start_[r + 1] = cell_start_[r] + counts_[order_[r]];
+    }
+    cell_keys_.swap(sorted_keys_);
+    for (Bucket& b : table_) {
+        if (b.key != NO_CELL) b.slot = rank_[b.slot];
+    }
+    update_bounds();
+    first_slot_.clear();
+    first_slot_.shrink_to_fit();
+    first_agent_.clear();
+    first_agent_.shrink_to_fit();
+
+    // Pass 3: stable scatter, so each cell lists its agents in index order
+    indices_.resize(cell_start_[m]);
+    cursor_.assign(cell_start_.begin(), cell_start_.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t slot = agent_slot_[i];
+        if (slot != NO_SLOT) indices_[cursor_[rank_[slot]]++] = static_cast<uint32_t>(i);
+    }
+}
+
+// agent_cell_ still holds the cells of the last build and new_cell_ the
+// current ones. Old cells and arrivals are merged in key order: runs of cells
+// nobody entered or left are copied as one block, the other cells drop their
+// leavers and merge in their arrivals by index, cells left empty are dropped
+// and cells only arrivals occupy are added.
+void SpatialGrid::relocate() {
+    const size_t m = cell_keys_.size();
+    const size_t n = new_cell_.size();
+    const size_t prev_n = agent_cell_.size();
+
+    dirty_.assign(m, 0);
+    arrivals_.clear();
+    size_t leavers = 0;
+    for (uint32_t i : moved_) {
+        const uint64_t from = i < prev_n ? agent_cell_[i] : NO_CELL;
+        const uint64_t to = new_cell_[i];
+        if (from != NO_CELL) {
+            dirty_[find(from)] = 1;
+            leavers++;
+        }
+        if (to != NO_CELL) {
+            const uint32_t slot = find(to);
+            if (slot != NO_SLOT) dirty_[slot] = 1;
+            arrivals_.push_back({to, i});
+        }
+    }
+    for (size_t i = n; i < prev_n; ++i) {
+        if (agent_cell_[i] == NO_CELL) continue;
+        dirty_[find(agent_cell_[i])] = 1;
+        leavers++;
+    }
+
+    // Ordered by cell, then by index
+    std::sort(arrivals_.begin(), arrivals_.end());
+    auto arrival = arrivals_.begin();
+
+    next_keys_.clear();
+    next_start_.clear();
+    next_indices_.resize(indices_.size() - leavers + arrivals_.size());
+    const uint32_t* in = indices_.data();
+    uint32_t* out = next_indices_.data();
+
+    uint32_t w = 0;        // Write position in next_indices_
+    uint32_t run = 0;      // Start of the pending run of clean cells in indices_
+    uint32_t run_out = 0;  // and where it goes
+    bool reshaped = false; // Cells appeared or vanished
+    size_t s = 0;
+    while (s < m || arrival != arrivals_.end()) {
+        const bool old_cell = s < m && (arrival == arrivals_.end() || cell_keys_[s] <= arrival->key);
+        const uint64_t key = old_cell ? cell_keys_[s] : arrival->key;
+        const uint32_t begin = cell_start_[s];
+        const uint32_t end = old_cell ? cell_start_[s + 1] : begin;
+
+        if (old_cell && !dirty_[s]) {
+            next_keys_.push_back(key);
+            next_start_.push_back(w);
+            w += end - begin;
+            s++;
+            continue;
+        }
+
+        std::copy(in + run, in + begin, out + run_out);
+        const uint32_t start = w;
+        auto arrives_before = [&](uint32_t i) {
+            return arrival != arrivals_.end() && arrival->key == key && arrival->agent < i;
+        };
+        for (uint32_t k = begin; k < end; ++k) {
+            const uint32_t i = in[k];
+            if (i >= n || new_cell_[i] != key) continue;  // Left the cell
+            while (arrives_before(i)) out[w++] = (arrival++)->agent;
+            out[w++] = i;
+        }
+        while (arrives_before(std::numeric_limits<uint32_t>::max())) out[w++] = (arrival++)->agent;
+
+        if (w > start) {
+            next_keys_.push_back(key);
+            next_start_.push_back(start);
+        }
+        reshaped |= !old_cell || w == start;
+        if (old_cell) s++;
+        run = end;
+        run_out = w;
     }
+    std::copy(in + run, in + cell_start_[m], out + run_out);
+    next_start_.push_back(w);
+
+    indices_.swap(next_indices_);
+    cell_start_.swap(next_start_);
+    cell_keys_.swap(next_keys_);
+    if (reshaped) rebuild_index();
+    else refresh_offsets();
 }
 
-void SpatialGrid::query_cell(const Vec2& pos, std::function<void(size_t)> callback) const {
-    int gx = to_grid_x(pos.x);
-    int gy = to_grid_y(pos.y);
-    
-    if (!in_bounds(gx, gy)) return;
-    
-    const auto& cell = cells_[to_cell_index(gx, gy)];
-    for (size_t idx : cell) {
-        callback(idx);
+void SpatialGrid::compact_indices() {
+    constexpr uint32_t DROPPED = std::numeric_limits<uint32_t>::max();
+    const size_t m = cell_keys_.size();
+
+    // In place: the write positions never pass the read positions, and
+    // remap_ preserves order, so cells stay sorted by index. Cells left empty
+    // are dropped.
+    uint32_t w = 0;
+    size_t kept_cells = 0;
+    for (size_t c = 0; c < m; ++c) {
+        const uint32_t begin = cell_start_[c];
+        const uint32_t end = cell_start_[c + 1];
+        const uint32_t start = w;
+        for (uint32_t k = begin; k < end; ++k) {
+            const uint32_t r = remap_[indices_[k]];
+            if (r != DROPPED) indices_[w++] = r;
+        }
+        if (w == start) continue;
+        cell_keys_[kept_cells] = cell_keys_[c];
+        cell_start_[kept_cells++] = start;
     }
+    cell_start_[kept_cells] = w;
+    cell_start_.resize(kept_cells + 1);
+    indices_.resize(w);
+
+    cell_keys_.resize(kept_cells);
+    if (kept_cells < m) rebuild_index();
+    else refresh_offsets();
 }
@@ -1,30 +1,424 @@
 #pragma once
 #include <vector>
-#include <functional>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
 #include "agent.hpp"
 
+// Result of a nearest-neighbour query for one class of agents
+struct NearestHit {
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    size_t index = NONE;
+    double dist2 = std::numeric_limits<double>::infinity();
+
+    bool found() const { return index != NONE; }
+};
+
+/**
+ * @brief Uniform grid of square cells, indexed sparsely and stored in CSR form.
+ *
+ * Cells are 2 * world_size / grid_cells wide, aligned so that grid_cells of
+ * them span [-world_size, world_size], but only occupied cells are stored:
+ * cell_keys_ lists them in row-major order and cell c owns
+ * indices_[cell_start_[c] .. cell_start_[c + 1]). Cells are found in O(1)
+ * through a flat table over the bounding box of the occupied cells while
+ * they fill at least a quarter of it, and through an open-addressing hash of
+ * the cell key when they are more scattered than that. Memory therefore
+ * grows with the number of occupied cells rather than with the area of the
+ * world, and an agent outside [-world_size, world_size] simply lands in a
+ * cell of its own instead of being dropped. Within a cell, agents keep ascending index order
+ * and queries walk cells row by row, so every query visits candidates in a
+ * deterministic order. Queries are templates so the visitor is inlined.
+ *
+ * With wrap set the world is a torus of grid_cells x grid_cells cells:
+ * positions are taken modulo the world, queries reach across the edges, and
+ * distances should be measured with offset(), which picks the shorter way
+ * around.
+ *
+ * Between steps most agents stay in their cell, so update() can maintain the
+ * index incrementally: it remembers each agent's cell, relocates only the
+ * agents whose cell changed and merges them back in index order. compact()
+ * follows the removal of dead agents so surviving agents keep their cells.
+ * Either way the index is identical to what rebuild() would produce.
+ */
 class SpatialGrid {
 public:
-    SpatialGrid(double world_size, int grid_cells);
-    
-    void clear();
-    void insert(size_t agent_idx, const Vec2& pos);
-    
-    // Query agents within a radius of a position
-    void query_radius(const Vec2& pos, double radius, 
-                     std::function<void(size_t)> callback) const;
-    
-    // Get all agents in the same cell
-    void query_cell(const Vec2& pos, std::function<void(size_t)> callback) const;
+    SpatialGrid(double world_size, int grid_cells, bool wrap = false);
+
+    // Rebuild the index from scratch for agents [0, n) whose include(i) is true
+    template <class IncludeFn>
+    void rebuild(const Real* xs, const Real* ys, size_t n, IncludeFn include);
+
+    // Same result as rebuild(), but only agents whose cell changed since the
+    // last build are moved. Agents past the previous n are new. Falls back to
+    // a full rebuild (and returns false) when more than max_churn * n agents
+    // changed cell, appeared or disappeared.
+    template <class IncludeFn>
+    bool update(const Real* xs, const Real* ys, size_t n, IncludeFn include,
+                double max_churn = 0.05);
+
+    // Mirror a stable compaction of agents [0, n): agents with keep(i) false
+    // are dropped and the rest shift down in order (AgentStore::remove_dead)
+    template <class KeepFn>
+    void compact(size_t n, KeepFn keep);
+
+    // Visit every indexed agent in a cell that intersects the circle around
+    // pos. Candidates may still lie outside the radius; callers filter by
+    // exact distance.
+    template <class F>
+    void for_each_in_radius(const Vec2& pos, double radius, F&& fn) const;
+
+    // Visit all agents in the same cell as pos
+    template <class F>
+    void for_each_in_cell(const Vec2& pos, F&& fn) const;
+
+    // Find the nearest agent of each requested class around pos.
+    // class_of(idx) maps an agent to a class in [0, num_classes), or -1 to
+    // skip it (e.g. the querying agent itself). Only classes whose bit is set
+    // in class_mask are searched. Cells are visited in rings of increasing
+    // Chebyshev distance and the search stops as soon as no unvisited cell
+    // can hold anything closer than the current best for every class.
+    // Ties are broken towards the lower agent index.
+    template <class ClassFn>
+    void query_nearest_per_class(const Vec2& pos, const Real* xs, const Real* ys,
+                                 ClassFn class_of, NearestHit* hits, int num_classes,
+                                 unsigned class_mask) const;
+
+    // Offset from a to b along one axis: b - a, or in wrap mode the shorter
+    // way around the world
+    Real offset(Real a, Real b) const {
+        Real d = b - a;
+        if (wrap_) {
+            if (d > half_period_) d -= period_;
+            else if (d < -half_period_) d += period_;
+        }
+        return d;
+    }
+
+    [[nodiscard]] bool wraps() const { return wrap_; }
+    [[nodiscard]] size_t occupied_cells() const { return cell_keys_.size(); }
 
 private:
+    static constexpr uint64_t NO_CELL = std::numeric_limits<uint64_t>::max();
+    static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+    static constexpr double MAX_COORD = 1 << 29;  // Cell coordinates are clamped to +-MAX_COORD
+
+    struct Bucket {
+        uint64_t key;   // NO_CELL if empty
+        uint32_t slot;  // Position of the cell in cell_keys_
+    };
+
+    struct Arrival {
+        uint64_t key;
+        uint32_t agent;
+        bool operator<(const Arrival& o) const { return key != o.key ? key < o.key : agent < o.agent; }
+    };
+
     double world_size_;
     int grid_cells_;
     double cell_size_;
-    std::vector<std::vector<size_t>> cells_;
-    
-    int to_grid_x(double x) const;
-    int to_grid_y(double y) const;
-    int to_cell_index(int gx, int gy) const;
-    bool in_bounds(int gx, int gy) const;
+    bool wrap_;
+    Real period_;       // 2 * world_size
+    Real half_period_;
+
+    std::vector<uint64_t> cell_keys_;   // Occupied cells, ascending (row-major)
+    std::vector<uint32_t> cell_start_;  // cell_keys_.size() + 1 offsets into indices_
+    std::vector<uint32_t> indices_;     // Agent indices sorted by cell
+    std::vector<uint64_t> agent_cell_;  // Cell of each agent at the last build, NO_CELL if not indexed
+
+    // Bounding box of the occupied cells; queries outside it find nothing
+    int min_gx_ = 0, max_gx_ = -1, min_gy_ = 0, max_gy_ = -1;
+
+    // Cell lookup. Dense: one entry per cell of the bounding box (row-major)
+    // plus one, holding the slot of the first occupied cell at or after it
+    // and that cell's offset into indices_, so a row of cells is two loads.
+    // Sparse: a hash from cell key to slot, a power of two buckets at most
+    // half full.
+    bool dense_ = true;
+    size_t box_width_ = 0;
+    std::vector<uint32_t> first_slot_;
+    std::vector<uint32_t> first_agent_;
+    std::vector<Bucket> table_;
+    int hash_shift_ = 64;
+
+    // Scratch for build_csr()
+    std::vector<uint32_t> agent_slot_;   // Slot of each agent in discovery order
+    std::vector<uint32_t> counts_;       // Agents per slot
+    std::vector<uint32_t> order_;        // Slots sorted by key
+    std::vector<uint32_t> rank_;         // Sorted position of each slot
+    std::vector<uint64_t> sorted_keys_;
+    std::vector<uint32_t> cursor_;       // Per-cell write position during the scatter
+
+    // Scratch for update() and compact()
+    std::vector<uint64_t> new_cell_;     // Cell of each agent now
+    std::vector<uint32_t> moved_;        // Agents whose cell changed, ascending
+    std::vector<Arrival> arrivals_;      // Agents entering a cell
+    std::vector<uint8_t> dirty_;         // Cells that gain or lose agents
+    std::vector<uint64_t> next_keys_;    // cell_keys_ being built
+    std::vector<uint32_t> next_start_;   // cell_start_ being built
+    std::vector<uint32_t> next_indices_; // indices_ being built
+    std::vector<uint32_t> remap_;        // New index of each indexed agent (compact)
+
+    // Sort indices_ by cell from agent_cell_: a counting sort over the
+    // bounding box when it is dense enough, otherwise through the hash
+    void build_csr();
+    bool build_dense(int x0, int y0, size_t width, size_t height);
+    void build_sparse();
+
+    // Rewrite the index after update() found the moved agents
+    void relocate();
+
+    // Drop and renumber indices_ entries through remap_
+    void compact_indices();
+
+    // Cell lookup over cell_keys_
+    uint32_t find(uint64_t key) const;  // NO_SLOT if the cell is empty
+    uint32_t insert(uint64_t key, uint32_t slot);  // Hash only: slot already stored for key, or slot
+    void reset_table(size_t cells);
+    void rebuild_index();     // After cells appeared or vanished
+    void refresh_offsets();   // After cell_start_ changed
+    void update_bounds();
+    static bool fits_dense(size_t area, size_t cells) { return area <= 4 * cells + 1024; }
+
+    uint64_t cell_of(double x, double y) const;  // NO_CELL for NaN
+    int lattice(double c) const;                 // Unwrapped cell coordinate of c
+    int wrap_coord(int g) const;                 // g modulo grid_cells
+
+    static uint64_t to_key(int gx, int gy) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(gy) ^ 0x80000000u) << 32 |
+               (static_cast<uint32_t>(gx) ^ 0x80000000u);
+    }
+    static int key_x(uint64_t key) { return static_cast<int>(static_cast<uint32_t>(key) ^ 0x80000000u); }
+    static int key_y(uint64_t key) { return static_cast<int>(static_cast<uint32_t>(key >> 32) ^ 0x80000000u); }
+
+    // Sparse lookup: first occupied cell in [gx0, gx1] of row gy, NO_SLOT if none is
+    uint32_t first_in_row(int gy, int gx0, int gx1) const;
+
+    // Visit indices of cells [gx0, gx1] in row gy; one contiguous span
+    template <class F>
+    void for_each_in_row(int gy, int gx0, int gx1, F&& fn) const;
+
+    // for_each_in_row() over unwrapped cell coordinates: clipped to the
+    // occupied cells, or in wrap mode taken around the world
+    template <class F>
+    void visit_row(int gy, int gx0, int gx1, F&& fn) const;
 };
+
+template <class IncludeFn>
+void SpatialGrid::rebuild(const Real* xs, const Real* ys, size_t n, IncludeFn include) {
+    agent_cell_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        agent_cell_[i] = include(i) ? cell_of(xs[i], ys[i]) : NO_CELL;
+    }
+    build_csr();
+}
+
+template <class IncludeFn>
+bool SpatialGrid::update(const Real* xs, const Real* ys, size_t n, IncludeFn include,
+                         double max_churn) {
+    const size_t prev_n = agent_cell_.size();
+    new_cell_.resize(n);
+    moved_.clear();
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t cell = include(i) ? cell_of(xs[i], ys[i]) : NO_CELL;
+        new_cell_[i] = cell;
+        if (cell != (i < prev_n ? agent_cell_[i] : NO_CELL)) moved_.push_back(static_cast<uint32_t>(i));
+    }
+
+    size_t churn = moved_.size();
+    for (size_t i = n; i < prev_n; ++i) {
+        if (agent_cell_[i] != NO_CELL) churn++;
+    }
+
+    if (churn > max_churn * static_cast<double>(n)) {
+        agent_cell_.swap(new_cell_);
+        build_csr();
+        return false;
+    }
+    if (churn > 0) relocate();
+    agent_cell_.swap(new_cell_);
+    return true;
+}
+
+template <class KeepFn>
+void SpatialGrid::compact(size_t n, KeepFn keep) {
+    constexpr uint32_t DROPPED = std::numeric_limits<uint32_t>::max();
+    const size_t prev_n = agent_cell_.size();
+    remap_.resize(prev_n);
+
+    // Agents past the last build are not indexed and land behind the
+    // survivors, where update() treats them as new
+    uint32_t kept = 0;
+    for (size_t i = 0; i < prev_n; ++i) {
+        if (i < n && keep(i)) {
+            agent_cell_[kept] = agent_cell_[i];
+            remap_[i] = kept++;
+        } else {
+            remap_[i] = DROPPED;
+        }
+    }
+    if (kept == prev_n) return;
+
+    agent_cell_.resize(kept);
+    compact_indices();
+}
+
+template <class F>
+void SpatialGrid::for_each_in_row(int gy, int gx0, int gx1, F&& fn) const {
+    uint32_t begin, end;
+    if (dense_) {
+        gx0 = std::max(gx0, min_gx_);
+        gx1 = std::min(gx1, max_gx_);
+        if (gy < min_gy_ || gy > max_gy_ || gx0 > gx1) return;
+        const size_t row = static_cast<size_t>(gy - min_gy_) * box_width_;
+        begin = first_agent_[row + (gx0 - min_gx_)];
+        end = first_agent_[row + (gx1 - min_gx_) + 1];
+    } else {
+        if (gx0 > gx1) return;
+        const uint32_t first = first_in_row(gy, gx0, gx1);
+        if (first == NO_SLOT) return;
+
+        // Occupied cells of a row are adjacent in cell_keys_
+        const uint64_t last = to_key(gx1, gy);
+        uint32_t stop = first + 1;
+        while (stop < cell_keys_.size() && cell_keys_[stop] <= last) ++stop;
+        begin = cell_start_[first];
+        end = cell_start_[stop];
+    }
+
+    for (uint32_t k = begin; k < end; ++k) {
+        fn(static_cast<size_t>(indices_[k]));
+    }
+}
+
+template <class F>
+void SpatialGrid::visit_row(int gy, int gx0, int gx1, F&& fn) const {
+    if (!wrap_) {
+        if (gy < min_gy_ || gy > max_gy_) return;
+        for_each_in_row(gy, std::max(gx0, min_gx_), std::min(gx1, max_gx_), fn);
+        return;
+    }
+
+    // At most once around, split where the row crosses the edge
+    const int row = wrap_coord(gy);
+    const int first = wrap_coord(gx0);
+    const int last = first + std::min(gx1 - gx0, grid_cells_ - 1);
+    if (last < grid_cells_) {
+        for_each_in_row(row, first, last, fn);
+    } else {
+        for_each_in_row(row, first, grid_cells_ - 1, fn);
+        for_each_in_row(row, 0, last - grid_cells_, fn);
+    }
+}
+
+template <class F>
+void SpatialGrid::for_each_in_radius(const Vec2& pos, double radius, F&& fn) const {
+    const double r2 = radius * radius;
+    int gy0 = lattice(pos.y - radius);
+    int gy1 = lattice(pos.y + radius);
+    if (wrap_) {
+        // A circle taller than the world touches every row, and reaches
+        // some from both sides; just visit every cell once
+        if (gy1 - gy0 >= grid_cells_) {
+            for (int gy = 0; gy < grid_cells_; ++gy) for_each_in_row(gy, 0, grid_cells_ - 1, fn);
+            return;
+        }
+    } else {
+        gy0 = std::max(gy0, min_gy_);
+        gy1 = std::min(gy1, max_gy_);
+    }
+
+    for (int gy = gy0; gy <= gy1; ++gy) {
+        // Vertical gap between pos and this row of cells
+        const double row_lo = gy * cell_size_ - world_size_;
+        const double row_hi = row_lo + cell_size_;
+        const double gap = pos.y < row_lo ? row_lo - pos.y : (pos.y > row_hi ? pos.y - row_hi : 0.0);
+
+        // Horizontal half-width of the circle where it crosses the row
+        const double half = std::sqrt(std::max(r2 - gap * gap, 0.0));
+        visit_row(gy, lattice(pos.x - half), lattice(pos.x + half), fn);
+    }
+}
+
+template <class F>
+void SpatialGrid::for_each_in_cell(const Vec2& pos, F&& fn) const {
+    const uint64_t key = cell_of(pos.x, pos.y);
+    if (key == NO_CELL) return;
+
+    for_each_in_row(key_y(key), key_x(key), key_x(key), fn);
+}
+
+template <class ClassFn>
+void SpatialGrid::query_nearest_per_class(const Vec2& pos, const Real* xs, const Real* ys,
+                                          ClassFn class_of, NearestHit* hits, int num_classes,
+                                          unsigned class_mask) const {
+    if (class_mask == 0 || cell_keys_.empty()) return;
+
+    // Block of cells that can hold candidates: the occupied ones, or in wrap
+    // mode the grid_cells x grid_cells cells nearest around pos
+    int cx = lattice(pos.x), cy = lattice(pos.y);
+    int bx0, bx1, by0, by1;
+    if (wrap_) {
+        bx0 = cx - (grid_cells_ - 1) / 2, bx1 = bx0 + grid_cells_ - 1;
+        by0 = cy - (grid_cells_ - 1) / 2, by1 = by0 + grid_cells_ - 1;
+    } else {
+        bx0 = min_gx_, bx1 = max_gx_, by0 = min_gy_, by1 = max_gy_;
+        cx = std::clamp(cx, bx0, bx1);
+        cy = std::clamp(cy, by0, by1);
+    }
+
+    auto visit = [&](size_t idx) {
+        int c = class_of(idx);
+        if (c < 0 || c >= num_classes || !(class_mask & (1u << c))) return;
+
+        const Real dx = offset(pos.x, xs[idx]);
+        const Real dy = offset(pos.y, ys[idx]);
+        const Real d2 = dx*dx + dy*dy;
+        NearestHit& hit = hits[c];
+        if (d2 < hit.dist2 || (d2 == hit.dist2 && idx < hit.index)) {
+            hit.index = idx;
+            hit.dist2 = d2;
+        }
+    };
+
+    for (int r = 0; ; ++r) {
+        const int x0 = cx - r, x1 = cx + r;
+        const int y0 = cy - r, y1 = cy + r;
+
+        // Visit the cells at exactly Chebyshev distance r (clipped to the block)
+        const int gx_lo = std::max(x0, bx0), gx_hi = std::min(x1, bx1);
+        if (y0 >= by0) visit_row(y0, gx_lo, gx_hi, visit);
+        if (r > 0) {
+            if (y1 <= by1) visit_row(y1, gx_lo, gx_hi, visit);
+            const int gy_lo = std::max(y0 + 1, by0), gy_hi = std::min(y1 - 1, by1);
+            for (int gy = gy_lo; gy <= gy_hi; ++gy) {
+                if (x0 >= bx0) visit_row(gy, x0, x0, visit);
+                if (x1 <= bx1) visit_row(gy, x1, x1, visit);
+            }
+        }
+
+        // Whole block covered
+        if (x0 <= bx0 && x1 >= bx1 && y0 <= by0 && y1 >= by1) return;
+
+        // Distance from pos to the nearest side of the scanned block that
+        // still has unvisited cells beyond it. Around a torus, cells beyond
+        // one side are also reached across the opposite one.
+        double reach = std::numeric_limits<double>::infinity();
+        if (x0 > bx0 || wrap_) reach = std::min(reach, pos.x - (x0 * cell_size_ - world_size_));
+        if (x1 < bx1 || wrap_) reach = std::min(reach, ((x1 + 1) * cell_size_ - world_size_) - pos.x);
+        if (y0 > by0 || wrap_) reach = std::min(reach, pos.y - (y0 * cell_size_ - world_size_));
+        if (y1 < by1 || wrap_) reach = std::min(reach, ((y1 + 1) * cell_size_ - world_size_) - pos.y);
+
+        reach = std::max(reach, 0.0);
+        bool done = true;
+        for (int c = 0; c < num_classes; ++c) {
+            if ((class_mask & (1u << c)) && !(hits[c].dist2 < reach * reach)) {
+                done = false;
+                break;
+            }
+        }
+        if (done) return;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief Bounded lock-free single-producer single-consumer queue.
+ *
+ * A power-of-two ring of slots with one index owned by each side. The
+ * producer publishes a slot by advancing tail_ with release ordering and the
+ * consumer frees it by advancing head_, so neither side ever takes a lock or
+ * waits for the other; a full or empty queue is reported to the caller
+ * instead. Each index sits on its own cache line, as does the copy of the
+ * other side's index that each keeps to avoid touching the shared line on
+ * every call.
+ *
+ * Exactly one thread may call try_push() and exactly one thread try_pop().
+ *
+ * Example usage:
+ *
+ * SpscQueue<StatsSnapshot> queue(1024);
+ * while (!queue.try_push(snap)) std::this_thread::yield();  // Producer
+ * StatsSnapshot s; while (queue.try_pop(s)) write(s);       // Consumer
+ */
+template <class T>
+class SpscQueue {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        mask_ = size - 1;
+        slots_ = std::make_unique<T[]>(size);
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool try_push(const T& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) return false;
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) return false;
+        }
+        value = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] size_t capacity() const { return mask_ + 1; }
+
+private:
+    static constexpr size_t LINE = 64;
+
+    std::unique_ptr<T[]> slots_;
+    size_t mask_ = 0;
+
+    alignas(LINE) std::atomic<size_t> head_{0};  // Next slot to pop (consumer)
+    alignas(LINE) size_t cached_tail_ = 0;        // Consumer's view of tail_
+    alignas(LINE) std::atomic<size_t> tail_{0};  // Next slot to push (producer)
+    alignas(LINE) size_t cached_head_ = 0;        // Producer's view of head_
+};
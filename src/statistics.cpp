@@ -1,16 +1,93 @@
 #include "statistics.hpp"
 #include "world.hpp"
+#include "config.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
-#include <iomanip>
-#include <numeric>
+#include <iterator>
 
-Statistics::Statistics(const std::string& output_file, bool enabled)
-    : output_file_(output_file), enabled_(enabled) {
+namespace {
+
+// Column layout shared by the CSV and binary writers and the converter
+struct Column {
+    const char* name;
+    char type;  // 'i' int32, 'd' float64
+    size_t offset;
+};
+
+constexpr Column COLUMNS[] = {
+    {"step", 'i', offsetof(StatsSnapshot, step)},
+    {"time", 'd', offsetof(StatsSnapshot, time)},
+    {"total_agents", 'i', offsetof(StatsSnapshot, total_agents)},
+    {"predators", 'i', offsetof(StatsSnapshot, predators)},
+    {"prey", 'i', offsetof(StatsSnapshot, prey)},
+    {"avg_energy", 'd', offsetof(StatsSnapshot, avg_energy)},
+    {"avg_predator_energy", 'd', offsetof(StatsSnapshot, avg_predator_energy)},
+    {"avg_prey_energy", 'd', offsetof(StatsSnapshot, avg_prey_energy)},
+    {"births", 'i', offsetof(StatsSnapshot, births)},
+    {"deaths", 'i', offsetof(StatsSnapshot, deaths)},
+    {"energy_p10", 'd', offsetof(StatsSnapshot, energy_p10)},
+    {"energy_p50", 'd', offsetof(StatsSnapshot, energy_p50)},
+    {"energy_p90", 'd', offsetof(StatsSnapshot, energy_p90)},
+    {"age_p50", 'd', offsetof(StatsSnapshot, age_p50)},
+    {"age_p90", 'd', offsetof(StatsSnapshot, age_p90)},
+    {"generation_p50", 'd', offsetof(StatsSnapshot, generation_p50)},
+    {"generation_p90", 'd', offsetof(StatsSnapshot, generation_p90)},
+    {"kills_p90", 'd', offsetof(StatsSnapshot, kills_p90)},
+};
+
+constexpr char MAGIC[8] = {'P', 'L', 'S', 'T', 'A', 'T', 'S', '\0'};
+constexpr uint32_t VERSION = 1;
+
+size_t type_size(char type) { return type == 'd' ? sizeof(double) : sizeof(int32_t); }
+
+// Write one value in the same text form for the CSV writer and the converter
+void write_value(std::ostream& out, char type, const char* bytes) {
+    if (type == 'd') {
+        double v;
+        std::memcpy(&v, bytes, sizeof(v));
+        out << v;
+    } else {
+        int32_t v;
+        std::memcpy(&v, bytes, sizeof(v));
+        out << v;
+    }
+}
+
+template <class T>
+void put(std::string& buffer, const T& value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+StatsOptions StatsOptions::from_config(const SimulationConfig& config) {
+    StatsOptions options;
+    if (config.stats_format == "binary") {
+        options.format = StatsFormat::Binary;
+    } else if (config.stats_format != "csv") {
+        std::cerr << "[Statistics] Unknown stats_format '" << config.stats_format
+                  << "', writing CSV" << std::endl;
+    }
+    options.flush_rows = config.stats_flush_rows;
+    options.flush_seconds = config.stats_flush_seconds;
+    options.history_length = static_cast<size_t>(std::max(config.stats_history_length, 0));
+    return options;
+}
+
+Statistics::Statistics(const std::string& output_file, bool enabled, const StatsOptions& options)
+    : output_file_(output_file), enabled_(enabled), options_(options) {
+    options_.flush_rows = std::max(options_.flush_rows, 1);
     if (enabled_) {
-        csv_file_.open(output_file_);
-        if (csv_file_.is_open()) {
+        const bool binary = options_.format == StatsFormat::Binary;
+        file_.open(output_file_, binary ? std::ios::out | std::ios::binary : std::ios::out);
+        if (file_.is_open()) {
             write_header();
-            std::cout << "[Statistics] Logging to " << output_file_ << std::endl;
+            writer_ = std::thread(&Statistics::writer_loop, this);
+            std::cout << "[Statistics] Logging to " << output_file_
+                      << (binary ? " (binary)" : "") << std::endl;
         } else {
             std::cerr << "[Statistics] Failed to open " << output_file_ << std::endl;
             enabled_ = false;
@@ -19,83 +96,191 @@ Statistics::Statistics(const std::string& output_file, bool enabled)
 }
 
 Statistics::~Statistics() {
-    flush();
-    if (csv_file_.is_open()) {
-        csv_file_.close();
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(signal_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+    }
+    if (file_.is_open()) {
+        file_.close();
     }
 }
 
 void Statistics::write_header() {
-    csv_file_ << "step,time,total_agents,predators,prey,avg_energy,"
-              << "avg_predator_energy,avg_prey_energy,births,deaths\n";
+    if (options_.format == StatsFormat::Csv) {
+        for (size_t c = 0; c < std::size(COLUMNS); ++c) {
+            file_ << (c ? "," : "") << COLUMNS[c].name;
+        }
+        file_ << "\n";
+        return;
+    }
+
+    std::string header(MAGIC, sizeof(MAGIC));
+    put(header, VERSION);
+    put(header, static_cast<uint32_t>(std::size(COLUMNS)));
+    for (const Column& column : COLUMNS) {
+        header.push_back(column.type);
+        header.push_back(static_cast<char>(std::strlen(column.name)));
+        header.append(column.name);
+    }
+    file_.write(header.data(), static_cast<std::streamsize>(header.size()));
+}
+
+void Statistics::write_rows(const std::vector<StatsSnapshot>& rows) {
+    if (options_.format == StatsFormat::Csv) {
+        for (const StatsSnapshot& snap : rows) {
+            const char* bytes = reinterpret_cast<const char*>(&snap);
+            for (size_t c = 0; c < std::size(COLUMNS); ++c) {
+                if (c) file_ << ",";
+                write_value(file_, COLUMNS[c].type, bytes + COLUMNS[c].offset);
+            }
+            file_ << "\n";
+        }
+    } else {
+        // The whole block goes out in one write, so a crash leaves at most
+        // one partial block at the end of the file
+        std::string block;
+        put(block, static_cast<uint32_t>(rows.size()));
+        for (const Column& column : COLUMNS) {
+            for (const StatsSnapshot& snap : rows) {
+                block.append(reinterpret_cast<const char*>(&snap) + column.offset, type_size(column.type));
+            }
+        }
+        file_.write(block.data(), static_cast<std::streamsize>(block.size()));
+    }
+    file_.flush();
+}
+
+void Statistics::writer_loop() {
+    using clock = std::chrono::steady_clock;
+    const size_t batch = static_cast<size_t>(options_.flush_rows);
+    const bool timed = options_.flush_seconds > 0.0;
+    // Without a time limit the timeout only bounds how long a stop can go unseen
+    const auto timeout = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(timed ? options_.flush_seconds : 1.0));
+
+    std::vector<StatsSnapshot> rows;
+    rows.reserve(batch);
+    auto last_write = clock::now();
+
+    for (;;) {
+        uint64_t requested;
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(signal_mutex_);
+            wake_.wait_for(lock, timeout, [&]() {
+                return data_ready_ || stop_ || flush_requested_ != flush_done_;
+            });
+            data_ready_ = false;
+            requested = flush_requested_;
+            stopping = stop_;
+        }
+
+        StatsSnapshot snap;
+        while (queue_.try_pop(snap)) {
+            rows.push_back(snap);
+            if (rows.size() == batch) {
+                write_rows(rows);
+                rows.clear();
+                last_write = clock::now();
+            }
+        }
+
+        const bool due = timed && clock::now() - last_write >= timeout;
+        const bool flushing = requested != flush_done_;
+        if (!rows.empty() && (due || flushing || stopping)) {
+            write_rows(rows);
+            rows.clear();
+            last_write = clock::now();
+        }
+
+        if (flushing) {
+            {
+                std::lock_guard<std::mutex> lock(signal_mutex_);
+                flush_done_ = requested;
+            }
+            flushed_.notify_all();
+        }
+        if (stopping) break;
+    }
 }
 
-void Statistics::write_snapshot(const StatsSnapshot& snap) {
-    csv_file_ << snap.step << ","
-              << snap.time << ","
-              << snap.total_agents << ","
-              << snap.predators << ","
-              << snap.prey << ","
-              << snap.avg_energy << ","
-              << snap.avg_predator_energy << ","
-              << snap.avg_prey_energy << ","
-              << snap.births << ","
-              << snap.deaths << "\n";
+void Statistics::signal_writer() {
+    {
+        std::lock_guard<std::mutex> lock(signal_mutex_);
+        data_ready_ = true;
+    }
+    wake_.notify_one();
+    unsignaled_ = 0;
 }
 
 void Statistics::record_step(int step, double time, const World& world) {
     if (!enabled_) return;
 
+    const PopulationStats& population = world.population;
     StatsSnapshot snap;
     snap.step = step;
     snap.time = time;
-    snap.total_agents = world.agents.size();
-    snap.predators = 0;
-    snap.prey = 0;
-    
-    double total_energy = 0.0;
-    double predator_energy = 0.0;
-    double prey_energy = 0.0;
-
-    for (const auto& agent : world.agents) {
-        if (agent.predator) {
-            snap.predators++;
-            predator_energy += agent.energy;
-        } else {
-            snap.prey++;
-            prey_energy += agent.energy;
-        }
-        total_energy += agent.energy;
-    }
-
-    snap.avg_energy = snap.total_agents > 0 ? total_energy / snap.total_agents : 0.0;
-    snap.avg_predator_energy = snap.predators > 0 ? predator_energy / snap.predators : 0.0;
-    snap.avg_prey_energy = snap.prey > 0 ? prey_energy / snap.prey : 0.0;
+    snap.total_agents = population.total();
+    snap.predators = population.predators();
+    snap.prey = population.prey();
+    snap.avg_energy = population.avg_energy();
+    snap.avg_predator_energy = population.avg_energy(true);
+    snap.avg_prey_energy = population.avg_energy(false);
     snap.births = births_this_step_;
     snap.deaths = deaths_this_step_;
+    const double deciles[] = {0.1, 0.5, 0.9};
+    double q[3];
+    population.energy_quantiles(world.agents, deciles, q, 3);
+    snap.energy_p10 = q[0];
+    snap.energy_p50 = q[1];
+    snap.energy_p90 = q[2];
+    population.age.quantiles(world.step_count, deciles + 1, q, 2);
+    snap.age_p50 = q[0];
+    snap.age_p90 = q[1];
+    population.generation.quantiles(deciles + 1, q, 2);
+    snap.generation_p50 = q[0];
+    snap.generation_p90 = q[1];
+    snap.kills_p90 = population.kills.quantile(0.9);
+
+    if (options_.history_length > 0) {
+        if (history_.size() == options_.history_length) history_.pop_front();
+        history_.push_back(snap);
+    }
 
-    history_.push_back(snap);
-    write_snapshot(snap);
+    // Only a writer that has fallen a whole queue behind makes us wait
+    while (!queue_.try_push(snap)) {
+        signal_writer();
+        std::this_thread::yield();
+    }
+    if (++unsignaled_ >= options_.flush_rows) signal_writer();
 
     // Reset per-step counters
     births_this_step_ = 0;
     deaths_this_step_ = 0;
 }
 
-void Statistics::record_birth() {
-    births_this_step_++;
-    total_births_++;
+void Statistics::record_birth(int count) {
+    births_this_step_ += count;
+    total_births_ += count;
 }
 
-void Statistics::record_death() {
-    deaths_this_step_++;
-    total_deaths_++;
+void Statistics::record_death(int count) {
+    deaths_this_step_ += count;
+    total_deaths_ += count;
 }
 
 void Statistics::flush() {
-    if (csv_file_.is_open()) {
-        csv_file_.flush();
-    }
+    if (!writer_.joinable()) return;
+
+    std::unique_lock<std::mutex> lock(signal_mutex_);
+    const uint64_t ticket = ++flush_requested_;
+    wake_.notify_one();
+    flushed_.wait(lock, [&]() { return flush_done_ >= ticket; });
+    unsignaled_ = 0;
 }
 
 void Statistics::reset() {
@@ -105,3 +290,74 @@ void Statistics::reset() {
     births_this_step_ = 0;
     deaths_this_step_ = 0;
 }
+
+bool convert_stats_to_csv(const std::string& input_file, const std::string& output_file) {
+    std::ifstream in(input_file, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "[Statistics] Failed to open " << input_file << std::endl;
+        return false;
+    }
+
+    char magic[sizeof(MAGIC)];
+    uint32_t version = 0, column_count = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&column_count), sizeof(column_count));
+    if (!in || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        std::cerr << "[Statistics] " << input_file << " is not a binary statistics file" << std::endl;
+        return false;
+    }
+    if (version != VERSION) {
+        std::cerr << "[Statistics] " << input_file << " has unsupported version " << version << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> names(column_count);
+    std::vector<char> types(column_count);
+    for (uint32_t c = 0; c < column_count; ++c) {
+        char type = 0, length = 0;
+        in.get(type);
+        in.get(length);
+        names[c].resize(static_cast<unsigned char>(length));
+        in.read(names[c].data(), static_cast<std::streamsize>(names[c].size()));
+        if (!in || (type != 'i' && type != 'd')) {
+            std::cerr << "[Statistics] " << input_file << " has a corrupt column table" << std::endl;
+            return false;
+        }
+        types[c] = type;
+    }
+
+    std::ofstream out(output_file);
+    if (!out.is_open()) {
+        std::cerr << "[Statistics] Failed to open " << output_file << std::endl;
+        return false;
+    }
+    for (uint32_t c = 0; c < column_count; ++c) out << (c ? "," : "") << names[c];
+    out << "\n";
+
+    size_t total_rows = 0;
+    std::vector<std::vector<char>> columns(column_count);
+    uint32_t rows = 0;
+    while (in.read(reinterpret_cast<char*>(&rows), sizeof(rows))) {
+        bool complete = true;
+        for (uint32_t c = 0; c < column_count && complete; ++c) {
+            columns[c].resize(rows * type_size(types[c]));
+            complete = static_cast<bool>(in.read(columns[c].data(), static_cast<std::streamsize>(columns[c].size())));
+        }
+        if (!complete) {
+            std::cerr << "[Statistics] Ignoring a truncated block at the end of " << input_file << std::endl;
+            break;
+        }
+        for (uint32_t r = 0; r < rows; ++r) {
+            for (uint32_t c = 0; c < column_count; ++c) {
+                if (c) out << ",";
+                write_value(out, types[c], columns[c].data() + r * type_size(types[c]));
+            }
+            out << "\n";
+        }
+        total_rows += rows;
+    }
+
+    std::cout << "[Statistics] Wrote " << total_rows << " rows to " << output_file << std::endl;
+    return static_cast<bool>(out);
+}
@@ -1,7 +1,15 @@
 #pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
-#include <fstream>
+#include "spsc_queue.hpp"
+
+struct SimulationConfig;
 
 struct StatsSnapshot {
     int step;
@@ -14,37 +22,108 @@ struct StatsSnapshot {
     double avg_prey_energy;
     int births;
     int deaths;
+
+    // Distributions over the live population
+    double energy_p10, energy_p50, energy_p90;
+    double age_p50, age_p90;
+    double generation_p50, generation_p90;
+    double kills_p90;
+};
+
+enum class StatsFormat {
+    Csv,     // One text row per snapshot, readable by analyze_stats.py
+    Binary   // Columnar blocks; convert with convert_stats_to_csv()
+};
+
+struct StatsOptions {
+    StatsFormat format = StatsFormat::Csv;
+    int flush_rows = 256;         // Snapshots the writer batches before writing them out
+    double flush_seconds = 1.0;   // ...or the longest a snapshot waits (0 = only full batches)
+    size_t history_length = 1000; // Snapshots kept in memory for the GUI (0 = none)
+
+    static StatsOptions from_config(const SimulationConfig& config);
 };
 
+/**
+ * @brief Population statistics, written to disk by a background thread.
+ *
+ * record_step() reads a snapshot off World::population (no pass over the
+ * agents) and hands it to a writer thread through a
+ * lock-free single-producer queue, so the simulation thread never formats
+ * text or waits on the file. The writer batches snapshots and writes them out
+ * when flush_rows have piled up or flush_seconds have passed, whichever comes
+ * first; flush() waits until everything recorded so far is on disk.
+ *
+ * Only the last history_length snapshots are kept in memory.
+ *
+ * The binary format is a header followed by blocks of up to flush_rows
+ * snapshots, each stored column by column:
+ *
+ *   char[8]  "PLSTATS\0"
+ *   uint32   version, column count
+ *   columns: uint8 type ('i' int32, 'd' float64), uint8 name length, name
+ *   blocks:  uint32 rows, then each column's rows values
+ *
+ * A block cut short by a crash is ignored when reading.
+ *
+ * Example usage:
+ *
+ * Statistics stats("run.pstats", true, StatsOptions::from_config(config));
+ * stats.record_step(step, step * dt, world);
+ * stats.flush();
+ * convert_stats_to_csv("run.pstats", "run.csv");
+ */
 class Statistics {
 public:
-    Statistics(const std::string& output_file, bool enabled = true);
+    Statistics(const std::string& output_file, bool enabled = true, const StatsOptions& options = {});
     ~Statistics();
 
+    Statistics(const Statistics&) = delete;
+    Statistics& operator=(const Statistics&) = delete;
+
     void record_step(int step, double time, const class World& world);
-    void record_birth();
-    void record_death();
+    void record_birth(int count = 1);
+    void record_death(int count = 1);
     void flush();
     void reset();
 
-    const std::vector<StatsSnapshot>& get_history() const { return history_; }
+    const std::deque<StatsSnapshot>& get_history() const { return history_; }
     int total_births() const { return total_births_; }
     int total_deaths() const { return total_deaths_; }
 
 private:
     std::string output_file_;
     bool enabled_;
-    std::ofstream csv_file_;
-    std::vector<StatsSnapshot> history_;
-    
+    StatsOptions options_;
+    std::ofstream file_;
+    std::deque<StatsSnapshot> history_;
+
     // Cumulative counters
     int total_births_ = 0;
     int total_deaths_ = 0;
-    
+
     // Per-step counters (reset each snapshot)
     int births_this_step_ = 0;
     int deaths_this_step_ = 0;
 
+    // Writer thread. The queue carries the snapshots; the mutex only guards
+    // the wake-up, flush and stop signals below.
+    SpscQueue<StatsSnapshot> queue_{4096};
+    std::thread writer_;
+    std::mutex signal_mutex_;
+    std::condition_variable wake_;     // Writer: work is waiting
+    std::condition_variable flushed_;  // flush(): the writer caught up
+    bool data_ready_ = false;
+    bool stop_ = false;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_done_ = 0;
+    int unsignaled_ = 0;  // Snapshots pushed since the writer was last woken
+
+    void signal_writer();
+    void writer_loop();
     void write_header();
-    void write_snapshot(const StatsSnapshot& snap);
+    void write_rows(const std::vector<StatsSnapshot>& rows);
 };
+
+// Rewrite a binary statistics file as CSV with the columns Statistics writes
+bool convert_stats_to_csv(const std::string& input_file, const std::string& output_file);
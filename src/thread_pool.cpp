@@ -0,0 +1,69 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(int num_threads) {
+    if (num_threads <= 0) {
+        num_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    // The calling thread is the last member of the pool
+    workers_.reserve(num_threads - 1);
+    for (int i = 1; i < num_threads; ++i) {
+        workers_.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::drain(const std::function<void(size_t)>& task, size_t num_tasks) {
+    for (size_t t = next_task_.fetch_add(1); t < num_tasks; t = next_task_.fetch_add(1)) {
+        task(t);
+    }
+}
+
+void ThreadPool::run(size_t num_tasks, const std::function<void(size_t)>& task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        num_tasks_ = num_tasks;
+        next_task_.store(0);
+        active_workers_ = static_cast<int>(workers_.size());
+        ++job_id_;
+    }
+    work_cv_.notify_all();
+
+    drain(task, num_tasks);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this]() { return active_workers_ == 0; });
+    task_ = nullptr;
+}
+
+void ThreadPool::worker_loop() {
+    uint64_t seen_job = 0;
+    for (;;) {
+        const std::function<void(size_t)>* task;
+        size_t num_tasks;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [&]() { return stop_ || job_id_ != seen_job; });
+            if (stop_) return;
+            seen_job = job_id_;
+            task = task_;
+            num_tasks = num_tasks_;
+        }
+
+        drain(*task, num_tasks);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--active_workers_ == 0) done_cv_.notify_one();
+    }
+}
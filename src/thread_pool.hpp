@@ -0,0 +1,78 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size pool of worker threads for data-parallel loops.
+ *
+ * The calling thread takes part in every job, so a pool of size 1 spawns no
+ * workers and simply runs the loop inline. Work is handed out as contiguous
+ * index ranges; callers are expected to write only to state owned by the
+ * indices they were given so results do not depend on scheduling.
+ *
+ * Example usage:
+ *
+ * ThreadPool pool(4);
+ * pool.parallel_for(n, [&](size_t begin, size_t end) {
+ *     for (size_t i = begin; i < end; ++i) out[i] = f(in[i]);
+ * });
+ */
+class ThreadPool {
+public:
+    // num_threads <= 0 uses every hardware thread
+    explicit ThreadPool(int num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Total number of threads working on a job, including the caller
+    [[nodiscard]] int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    // Run fn(begin, end) over [0, count) split into contiguous chunks of at
+    // least min_chunk indices. Blocks until every chunk has finished.
+    template <typename Fn>
+    void parallel_for(size_t count, Fn&& fn, size_t min_chunk = 1024) {
+        if (count == 0) return;
+        min_chunk = std::max<size_t>(min_chunk, 1);
+        if (workers_.empty() || count <= min_chunk) {
+            fn(size_t{0}, count);
+            return;
+        }
+
+        // A few chunks per thread smooths out uneven per-agent cost
+        const size_t max_chunks = static_cast<size_t>(size()) * 4;
+        const size_t num_chunks = std::min((count + min_chunk - 1) / min_chunk, max_chunks);
+        const size_t chunk = (count + num_chunks - 1) / num_chunks;
+
+        run(num_chunks, [&](size_t c) {
+            const size_t begin = c * chunk;
+            const size_t end = std::min(count, begin + chunk);
+            if (begin < end) fn(begin, end);
+        });
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+
+    // Current job
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t num_tasks_ = 0;
+    std::atomic<size_t> next_task_{0};
+    int active_workers_ = 0;
+    uint64_t job_id_ = 0;
+    bool stop_ = false;
+
+    void run(size_t num_tasks, const std::function<void(size_t)>& task);
+    void drain(const std::function<void(size_t)>& task, size_t num_tasks);
+    void worker_loop();
+};
@@ -0,0 +1,79 @@
+#include "trail_buffer.hpp"
+#include <algorithm>
+
+void TrailBuffer::set_length(size_t length, size_t n) {
+    if (length == length_) {
+        resize(n);
+        return;
+    }
+
+    // Drop the old planes outright; a length change restarts every trail
+    length_ = length;
+    stride_ = 0;
+    size_ = 0;
+    head_ = 0;
+    steps_ = 0;
+    x_ = {};
+    y_ = {};
+    first_step_ = {};
+    resize(n);
+}
+
+void TrailBuffer::resize(size_t n) {
+    if (!enabled()) return;
+
+    if (n > stride_) {
+        // Re-lay the planes out at the new stride
+        const size_t stride = std::max(n, stride_ * 2);
+        std::vector<Real> x(length_ * stride), y(length_ * stride);
+        for (size_t p = 0; p < length_; ++p) {
+            std::copy_n(x_.begin() + p * stride_, size_, x.begin() + p * stride);
+            std::copy_n(y_.begin() + p * stride_, size_, y.begin() + p * stride);
+        }
+        x_.swap(x);
+        y_.swap(y);
+        stride_ = stride;
+    }
+    size_ = n;
+    first_step_.resize(n, steps_);
+}
+
+void TrailBuffer::write(const Real* xs, const Real* ys, size_t begin, size_t end) {
+    std::copy(xs + begin, xs + end, x_.begin() + head_ * stride_ + begin);
+    std::copy(ys + begin, ys + end, y_.begin() + head_ * stride_ + begin);
+}
+
+void TrailBuffer::advance() {
+    head_ = head_ + 1 == length_ ? 0 : head_ + 1;
+    steps_++;
+}
+
+void TrailBuffer::remove_dead(const std::vector<uint8_t>& flags, uint8_t alive_flag, size_t live) {
+    if (!enabled()) return;
+
+    // Slots before the first dead agent stay where they are
+    size_t first_dead = 0;
+    while (first_dead < size_ && (flags[first_dead] & alive_flag)) first_dead++;
+
+    // Only the planes that hold somebody's trail need compacting
+    const size_t planes = static_cast<size_t>(std::min<uint64_t>(steps_, length_));
+    for (size_t back = 1; back <= planes; ++back) {
+        const size_t p = (head_ + length_ - back) % length_;
+        Real* x = x_.data() + p * stride_;
+        Real* y = y_.data() + p * stride_;
+        size_t w = first_dead;
+        for (size_t r = first_dead; r < size_; ++r) {
+            if (!(flags[r] & alive_flag)) continue;
+            x[w] = x[r];
+            y[w] = y[r];
+            ++w;
+        }
+    }
+
+    size_t w = first_dead;
+    for (size_t r = first_dead; r < size_; ++r) {
+        if (flags[r] & alive_flag) first_step_[w++] = first_step_[r];
+    }
+    first_step_.resize(live);
+    size_ = live;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "agent.hpp"
+
+/**
+ * @brief Movement trails of every agent in one block of ring buffers.
+ *
+ * Every agent records its position on the same steps, so the ring is kept
+ * per step rather than per agent: length() planes of one x and one y per
+ * agent slot, and a single head naming the plane the next step writes.
+ * Recording a step is then a straight copy of the position columns into that
+ * plane, and each agent only keeps a count of how many of the most recent
+ * planes belong to it. Slots follow the agent columns: they grow with
+ * resize(), new slots start with an empty trail, and remove_dead() drops dead
+ * agents' slots together with the rest of AgentStore.
+ *
+ * A length of 0 (trails off) releases the storage, so a world that never
+ * shows trails pays nothing for them. Changing the length clears every trail.
+ *
+ * write() may run in parallel on disjoint ranges of slots; advance() then
+ * completes the step.
+ *
+ * Example usage:
+ *
+ * trails.set_length(20, agents.size());
+ * trails.write(xs, ys, 0, agents.size());
+ * trails.advance();
+ * for (size_t k = 0; k < trails.count(i); ++k) draw(trails.point(i, k));
+ */
+class TrailBuffer {
+public:
+    // Points kept per agent; 0 frees everything
+    void set_length(size_t length, size_t n);
+    [[nodiscard]] size_t length() const { return length_; }
+    [[nodiscard]] bool enabled() const { return length_ > 0; }
+
+    // Match the agent count; slots past the old size start empty
+    void resize(size_t n);
+
+    // Record positions of slots [begin, end) for the current step
+    void write(const Real* xs, const Real* ys, size_t begin, size_t end);
+
+    // Finish the step: every slot's trail gains the point just written
+    void advance();
+
+    // Recorded points of slot i; k = 0 is the oldest
+    [[nodiscard]] size_t count(size_t i) const {
+        if (!enabled()) return 0;
+        const uint64_t age = steps_ - first_step_[i];
+        return age < length_ ? static_cast<size_t>(age) : length_;
+    }
+    [[nodiscard]] Vec2 point(size_t i, size_t k) const {
+        size_t plane = head_ + length_ - count(i) + k;
+        if (plane >= length_) plane -= length_;
+        return {x_[plane * stride_ + i], y_[plane * stride_ + i]};
+    }
+
+    // Stable compaction mirroring AgentStore::remove_dead()
+    void remove_dead(const std::vector<uint8_t>& flags, uint8_t alive_flag, size_t live);
+
+private:
+    size_t length_ = 0;
+    size_t stride_ = 0;  // Slots per plane (capacity, at least the agent count)
+    size_t size_ = 0;    // Agent slots in use
+    size_t head_ = 0;    // Plane the next write() goes to
+    uint64_t steps_ = 0; // advance() calls since the length was set
+    std::vector<Real> x_, y_;           // length_ planes of stride_ slots
+    std::vector<uint64_t> first_step_;  // Value of steps_ when each slot's trail began
+};
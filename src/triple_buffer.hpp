@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free triple buffer handing the latest value from one thread to another.
+ *
+ * The writer fills back() and publish()es it; the reader calls update() and
+ * reads front(). Of the three slots one belongs to each side and the third
+ * holds the newest published value, so publishing and taking are single
+ * atomic exchanges. Neither side ever waits: the writer can publish as often
+ * as it likes (the reader only sees the newest value) and the reader keeps
+ * its front() until a newer one is published.
+ *
+ * Exactly one thread may write and exactly one read. Slots are reused, so a
+ * writer should overwrite back() in place to keep its allocations.
+ *
+ * Example usage:
+ *
+ * TripleBuffer<RenderSnapshot> frames;
+ * frames.back().capture(world, stats); frames.publish();  // Writer
+ * frames.update(); draw(frames.front());                  // Reader
+ */
+template <class T>
+class TripleBuffer {
+public:
+    // Writer: the slot to fill next
+    T& back() { return slots_[back_]; }
+
+    // Writer: make back() the newest value and take a free slot for the next
+    void publish() {
+        back_ = state_.exchange(static_cast<uint8_t>(back_ | FRESH), std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Writer: the last published value has not been taken by the reader yet
+    [[nodiscard]] bool pending() const { return state_.load(std::memory_order_relaxed) & FRESH; }
+
+    // Reader: switch front() to the newest value; false if nothing new was published
+    bool update() {
+        if (!(state_.load(std::memory_order_relaxed) & FRESH)) return false;
+        front_ = state_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    // Reader: the value taken by the last successful update()
+    const T& front() const { return slots_[front_]; }
+
+private:
+    static constexpr uint8_t INDEX = 3;  // Slot index bits of state_
+    static constexpr uint8_t FRESH = 4;  // The middle slot holds an untaken value
+
+    T slots_[3];
+    alignas(64) std::atomic<uint8_t> state_{1};  // Middle slot | FRESH
+    alignas(64) uint8_t back_ = 0;               // Writer's slot
+    alignas(64) uint8_t front_ = 2;              // Reader's slot
+};
@@ -1,11 +1,13 @@
 #include "visualize.hpp"
 #include <SDL2/SDL.h>
 #include <algorithm>
+#include <cmath>
 
 static SDL_Window* window = nullptr;
 static SDL_Renderer* renderer = nullptr;
 
-bool Visualizer::init(int width, int height) {
+bool Visualizer::init(int width, int height, int num_threads) {
+    pool_ = std::make_unique<ThreadPool>(num_threads);
     if (SDL_Init(SDL_INIT_VIDEO) < 0) return false;
     window = SDL_CreateWindow("Polaris", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                               width, height, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
@@ -14,14 +16,81 @@ bool Visualizer::init(int width, int height) {
     return true;
 }
 
-void Visualizer::draw(const World& world) {
+// Corners in order top-left, top-right, bottom-left, bottom-right
+void Visualizer::add_quad(const SDL_FPoint (&corners)[4], const SDL_Color (&colors)[4]) {
+    const int base = static_cast<int>(vertices_.size());
+    for (int k = 0; k < 4; ++k) vertices_.push_back({corners[k], colors[k], {0.0f, 0.0f}});
+
+    // The index pattern only depends on the quad's position, so it is
+    // written once and reused by every later frame
+    if (indices_.size() < static_cast<size_t>(base / 4 + 1) * 6) {
+        for (int k : {0, 1, 2, 2, 1, 3}) indices_.push_back(base + k);
+    }
+}
+
+void Visualizer::submit() {
+    if (!vertices_.empty()) {
+        SDL_RenderGeometry(renderer, nullptr, vertices_.data(), static_cast<int>(vertices_.size()),
+                           indices_.data(), static_cast<int>(vertices_.size() / 4 * 6));
+    }
+    vertices_.clear();
+}
+
+void Visualizer::clamp_view() {
+    zoom_ = std::clamp(zoom_, 1.0, MAX_ZOOM);
+    const double half = boundary_ / zoom_;
+    center_x_ = std::clamp(center_x_, -boundary_ + half, boundary_ - half);
+    center_y_ = std::clamp(center_y_, -boundary_ + half, boundary_ - half);
+}
+
+void Visualizer::reset_view() {
+    zoom_ = 1.0;
+    center_x_ = center_y_ = 0.0;
+}
+
+bool Visualizer::handle_event(const SDL_Event& event) {
+    const double scale = viewport_size_ * zoom_ / (2.0 * boundary_);  // Pixels per world unit
+    switch (event.type) {
+        case SDL_MOUSEWHEEL: {
+            // Keep the world point under the cursor where it is
+            int mx, my;
+            SDL_GetMouseState(&mx, &my);
+            const double wx = center_x_ + (mx - viewport_size_ * 0.5) / scale;
+            const double wy = center_y_ + (my - viewport_size_ * 0.5) / scale;
+            zoom_ = std::clamp(zoom_ * std::pow(1.25, event.wheel.y), 1.0, MAX_ZOOM);
+            const double new_scale = viewport_size_ * zoom_ / (2.0 * boundary_);
+            center_x_ = wx - (mx - viewport_size_ * 0.5) / new_scale;
+            center_y_ = wy - (my - viewport_size_ * 0.5) / new_scale;
+            clamp_view();
+            return true;
+        }
+        case SDL_MOUSEBUTTONDOWN:
+            if (event.button.button != SDL_BUTTON_LEFT) return false;
+            dragging_ = true;
+            return true;
+        case SDL_MOUSEBUTTONUP:
+            if (event.button.button != SDL_BUTTON_LEFT) return false;
+            dragging_ = false;
+            return true;
+        case SDL_MOUSEMOTION:
+            if (!dragging_) return false;
+            center_x_ -= event.motion.xrel / scale;
+            center_y_ -= event.motion.yrel / scale;
+            clamp_view();
+            return true;
+    }
+    return false;
+}
+
+void Visualizer::draw(const RenderSnapshot& frame, int heatmap_threshold) {
     // Get current window size
     int window_width, window_height;
     SDL_GetWindowSize(window, &window_width, &window_height);
     
     // Use the smaller dimension to keep square aspect ratio
-    int viewport_size = std::min(window_width, window_height);
-    const double scale = viewport_size / (2.0 * world.boundary);
+    viewport_size_ = std::max(std::min(window_width, window_height), 1);
+    boundary_ = frame.boundary > 0.0 ? frame.boundary : 1.0;
+    clamp_view();
     
     // Clear with black
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
@@ -29,56 +98,126 @@ void Visualizer::draw(const World& world) {
     
     // Draw fade effect over entire viewport
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 40);
-    SDL_Rect fade{0, 0, viewport_size, viewport_size};
+    SDL_Rect fade{0, 0, viewport_size_, viewport_size_};
     SDL_RenderFillRect(renderer, &fade);
 
-    for (auto& a : world.agents) {
-        if (!a.alive) continue;
-
-        // Draw trail first (so agents render on top)
-        if (!a.trail.empty()) {
-            for (size_t i = 1; i < a.trail.size(); ++i) {
-                int px1 = static_cast<int>((a.trail[i-1].x + world.boundary) * scale);
-                int py1 = static_cast<int>((a.trail[i-1].y + world.boundary) * scale);
-                int px2 = static_cast<int>((a.trail[i].x + world.boundary) * scale);
-                int py2 = static_cast<int>((a.trail[i].y + world.boundary) * scale);
-                
-                // Fade trail from dark to bright
-                int alpha = 30 + (i * 225 / a.trail.size());
-                
-                if (a.predator) {
-                    SDL_SetRenderDrawColor(renderer, 255, 50, 50, alpha);
-                } else {
-                    SDL_SetRenderDrawColor(renderer, 50, 200, 255, alpha);
-                }
-                
-                SDL_RenderDrawLine(renderer, px1, py1, px2, py2);
+    // Level of detail: a large population is binned over the view, and drawn
+    // per agent again once zooming in leaves few enough of it in view
+    const size_t threshold = static_cast<size_t>(std::max(heatmap_threshold, 0));
+    if (threshold > 0 && frame.size() > threshold) {
+        const int cells = std::max(viewport_size_ / HEATMAP_CELL_PIXELS, 1);
+        const double half = boundary_ / zoom_;
+        density_.accumulate(frame, center_x_ - half, center_y_ - half, 2.0 * half / cells, cells, cells, *pool_);
+        if (density_.total() > threshold && draw_heatmap()) return;
+    }
+    draw_sprites(frame);
+    // Don't present here - let ImGui render on top first
+}
+
+bool Visualizer::draw_heatmap() {
+    const int cells = density_.cols();
+    if (heatmap_size_ != cells) {
+        if (heatmap_) SDL_DestroyTexture(heatmap_);
+        heatmap_ = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, cells, cells);
+        heatmap_size_ = heatmap_ ? cells : 0;
+    }
+    if (!heatmap_) return false;
+
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(heatmap_, nullptr, &pixels, &pitch) < 0) return false;
+    density_.colorize(static_cast<uint8_t*>(pixels), pitch);
+    SDL_UnlockTexture(heatmap_);
+
+    SDL_Rect dst{0, 0, viewport_size_, viewport_size_};
+    SDL_RenderCopy(renderer, heatmap_, nullptr, &dst);
+    return true;
+}
+
+void Visualizer::draw_sprites(const RenderSnapshot& frame) {
+    const double scale = viewport_size_ * zoom_ / (2.0 * boundary_);
+    const double left = center_x_ - boundary_ / zoom_;
+    const double top = center_y_ - boundary_ / zoom_;
+    auto to_screen = [&](float x, float y) {
+        return SDL_FPoint{static_cast<float>((x - left) * scale), static_cast<float>((y - top) * scale)};
+    };
+
+    // Zoomed in, most of the population is off screen
+    const float margin = 10.0f;  // Largest sprite
+    const float limit = static_cast<float>(viewport_size_) + margin;
+    auto on_screen = [&](SDL_FPoint p) { return p.x > -margin && p.x < limit && p.y > -margin && p.y < limit; };
+
+    // Trails first (so agents render on top): each segment is a one pixel
+    // wide quad, fading from dark at the oldest point to bright at the newest.
+    // In a wrapping world a step that crossed an edge moves more than half
+    // the world along some axis; that segment is left out rather than drawn
+    // across the whole window.
+    if (frame.has_trails()) {
+        const float half_period = static_cast<float>(boundary_);
+        auto crosses_edge = [&](size_t i) {
+            return frame.wrap && (std::fabs(frame.trail_x[i] - frame.trail_x[i - 1]) > half_period ||
+                                  std::fabs(frame.trail_y[i] - frame.trail_y[i - 1]) > half_period);
+        };
+        for (size_t idx = 0; idx < frame.size(); ++idx) {
+            const size_t first = frame.trail_begin[idx];
+            const size_t trail_size = frame.trail_begin[idx + 1] - first;
+            const SDL_Color tint = frame.predator[idx] ? SDL_Color{255, 50, 50, 0} : SDL_Color{50, 200, 255, 0};
+            auto color_at = [&](size_t i) {
+                SDL_Color c = tint;
+                c.a = static_cast<Uint8>(30 + (i * 225 / trail_size));
+                return c;
+            };
+
+            for (size_t i = 1; i < trail_size; ++i) {
+                if (crosses_edge(first + i)) continue;
+                const SDL_FPoint a = to_screen(frame.trail_x[first + i - 1], frame.trail_y[first + i - 1]);
+                const SDL_FPoint b = to_screen(frame.trail_x[first + i], frame.trail_y[first + i]);
+                if (!on_screen(a) && !on_screen(b)) continue;
+
+                // Half a pixel to either side of the segment
+                const float dx = b.x - a.x, dy = b.y - a.y;
+                const float length = std::sqrt(dx * dx + dy * dy);
+                const float nx = length > 0.0f ? -dy / length * 0.5f : 0.5f;
+                const float ny = length > 0.0f ? dx / length * 0.5f : 0.0f;
+
+                const SDL_Color ca = color_at(i - 1), cb = color_at(i);
+                add_quad({{a.x + nx, a.y + ny}, {b.x + nx, b.y + ny}, {a.x - nx, a.y - ny}, {b.x - nx, b.y - ny}},
+                         {ca, cb, ca, cb});
             }
         }
+        submit();
+    }
 
-        // Draw agent
-        int px = static_cast<int>((a.pos.x + world.boundary) * scale);
-        int py = static_cast<int>((a.pos.y + world.boundary) * scale);
+    for (size_t idx = 0; idx < frame.size(); ++idx) {
+        const double energy = frame.energy[idx];
+        const SDL_FPoint p = to_screen(frame.x[idx], frame.y[idx]);
+        if (!on_screen(p)) continue;
+        const int px = static_cast<int>(p.x);
+        const int py = static_cast<int>(p.y);
         
         // Size based on energy (4-10 pixels)
-        int size = 4 + static_cast<int>(std::clamp(a.energy / 40.0, 0.0, 6.0));
-        SDL_Rect r{px - size/2, py - size/2, size, size};
+        int size = 4 + static_cast<int>(std::clamp(energy / 40.0, 0.0, 6.0));
+        const float left = static_cast<float>(px - size/2), top = static_cast<float>(py - size/2);
         
-        if (a.predator) {
+        SDL_Color color;
+        if (frame.predator[idx]) {
             // Red for predators, brightness based on energy
-            int brightness = 50 + static_cast<int>(std::clamp(a.energy * 2.0, 0.0, 205.0));
-            SDL_SetRenderDrawColor(renderer, brightness, 50, 50, 255);
+            int brightness = 50 + static_cast<int>(std::clamp(energy * 2.0, 0.0, 205.0));
+            color = {static_cast<Uint8>(brightness), 50, 50, 255};
         } else {
             // Blue for prey, brightness based on energy
-            int brightness = 50 + static_cast<int>(std::clamp(a.energy * 1.5, 0.0, 205.0));
-            SDL_SetRenderDrawColor(renderer, 50, brightness, 255, 255);
+            int brightness = 50 + static_cast<int>(std::clamp(energy * 1.5, 0.0, 205.0));
+            color = {50, static_cast<Uint8>(brightness), 255, 255};
         }
-        SDL_RenderFillRect(renderer, &r);
+        add_quad({{left, top}, {left + size, top}, {left, top + size}, {left + size, top + size}},
+                 {color, color, color, color});
     }
-    // Don't present here - let ImGui render on top first
+    submit();
 }
 
 void Visualizer::shutdown() {
+    if (heatmap_) SDL_DestroyTexture(heatmap_);
+    heatmap_ = nullptr;
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
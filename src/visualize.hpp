@@ -1,13 +1,55 @@
 #pragma once
-#include "world.hpp"
+#include "density_grid.hpp"
+#include "render_snapshot.hpp"
+#include "thread_pool.hpp"
 #include <SDL2/SDL.h>
+#include <memory>
+#include <vector>
 
 class Visualizer {
 public:
-    bool init(int width, int height);
-    void draw(const World& world);
+    static constexpr int HEATMAP_CELL_PIXELS = 4;  // Screen pixels per heatmap cell side
+    static constexpr double MAX_ZOOM = 64.0;
+
+    // num_threads sizes the pool that bins the heatmap (0 = all hardware threads)
+    bool init(int width, int height, int num_threads = 0);
+    // Above heatmap_threshold agents in view (0 = never) the frame is drawn
+    // as a density heatmap instead of one sprite per agent
+    void draw(const RenderSnapshot& frame, int heatmap_threshold);
     void shutdown();
+
+    // Mouse wheel zooms around the cursor, dragging pans; true if handled
+    bool handle_event(const SDL_Event& event);
+    void reset_view();
     
     SDL_Window* get_window();
     SDL_Renderer* get_renderer();
+
+private:
+    // View: the world square centered on (center_x_, center_y_) with half
+    // its side boundary / zoom_, kept inside the world
+    double zoom_ = 1.0;
+    double center_x_ = 0.0;
+    double center_y_ = 0.0;
+    bool dragging_ = false;
+    double boundary_ = 1.0;   // Of the last frame drawn
+    int viewport_size_ = 1;   // Pixels
+
+    // Geometry of one frame, submitted in one SDL_RenderGeometry call per
+    // layer. Kept between frames so drawing does not allocate.
+    std::vector<SDL_Vertex> vertices_;
+    std::vector<int> indices_;  // Two triangles per quad; only ever grows
+
+    // Heatmap level of detail: binned in parallel, uploaded to one
+    // streaming texture that is recreated only when the viewport resizes
+    std::unique_ptr<ThreadPool> pool_;
+    DensityGrid density_;
+    SDL_Texture* heatmap_ = nullptr;
+    int heatmap_size_ = 0;
+
+    void add_quad(const SDL_FPoint (&corners)[4], const SDL_Color (&colors)[4]);
+    void submit();
+    void clamp_view();
+    void draw_sprites(const RenderSnapshot& frame);
+    bool draw_heatmap();  // false if the texture is unavailable
 };
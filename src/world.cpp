@@ -1,346 +1,528 @@
 #include "world.hpp"
 #include "statistics.hpp"
-#include "neural_network.hpp"
-#include <random>
+#include "brain_pool.hpp"
+#include "thread_pool.hpp"
+#include "batched_inference.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
+#include "simd.hpp"
+#include <atomic>
 #include <cmath>
 #include <algorithm>
-#include <chrono>
 
-World::World(const SimulationConfig& cfg, unsigned seed) {
+World::World(const SimulationConfig& cfg, unsigned seed) : seed(seed) {
     config = const_cast<SimulationConfig*>(&cfg);
     boundary = cfg.boundary;
-    grid = std::make_unique<SpatialGrid>(boundary, cfg.grid_cells);
-
-    std::mt19937 rng(seed);
-    std::uniform_real_distribution<double> dist(-1.0, 1.0);
-    std::bernoulli_distribution predatorChance(cfg.predator_chance);
+    grid = std::make_unique<SpatialGrid>(boundary, cfg.grid_cells, cfg.wrap_world);
+    pool = std::make_unique<ThreadPool>(cfg.num_threads);
+    const NetworkShape shape{cfg.neural_input_size, cfg.neural_hidden_size, cfg.neural_output_size};
+    brains = std::make_unique<BrainPool>(shape);
+    inference_ = std::make_unique<BatchedInference>(shape);  // Specialized kernel if the shape has one
 
     agents.resize(cfg.num_agents);
     for (size_t i = 0; i < cfg.num_agents; ++i) {
-        auto& a = agents[i];
-        a.pos = {dist(rng) * boundary, dist(rng) * boundary};
-        a.vel = {dist(rng), dist(rng)};
-        a.predator = predatorChance(rng);
-        a.energy = cfg.initial_energy;
-        a.alive = true;
-        a.generation = 0;
-        
+        agents.id[i] = next_agent_id++;
+        CounterRng layout(seed, agents.id[i], step_count, RngStream::Layout);
+        place_randomly(i, layout);
+        agents.predator[i] = layout.bernoulli(cfg.predator_chance);
+        agents.energy[i] = static_cast<Real>(cfg.initial_energy);
+        agents.flags[i] = AgentStore::FLAG_ALIVE;
+        agents.generation[i] = 0;
+
         // Initialize neural network
         if (cfg.enable_ai) {
-            initialize_brain(a, seed + i);
+            initialize_brain(i);
         }
     }
+    population.recount(agents, step_count);
 }
 
+// Defined here where ThreadPool is complete
+World::~World() = default;
+
+// Every phase below runs data-parallel over agents. A phase only writes state
+// owned by the agent it is processing and reads other agents' state as it was
+// when the phase began, so the outcome is identical for any thread count.
 void World::update(double dt) {
+    // Index current positions; shared by sensing and interactions
+    {
+        ScopedPhase scope(profiler, Phase::GridRebuild);
+        rebuild_grid();
+    }
+
     // Apply AI control if enabled
     if (config && config->enable_ai) {
         apply_neural_control(dt);
     }
-    
-    handle_interactions(dt);
-    integrate_movement(dt);
-    handle_energy_and_reproduction(dt);
-    remove_dead_agents();
-    
-    // Update fitness and age
-    for (auto& a : agents) {
-        if (a.alive) {
-            a.age++;
-            a.fitness = a.age * 0.1 + a.energy * 0.5 + a.kills * 10.0;
-        }
+
+    {
+        ScopedPhase scope(profiler, Phase::Interactions);
+        handle_interactions(dt);
     }
+    {
+        ScopedPhase scope(profiler, Phase::Movement);
+        integrate_movement(dt);
+    }
+    {
+        ScopedPhase scope(profiler, Phase::EnergyReproduction);
+        handle_energy_and_reproduction(dt);
+    }
+    {
+        ScopedPhase scope(profiler, Phase::Compaction);
+        remove_dead_agents();
+    }
+    {
+        ScopedPhase scope(profiler, Phase::Fitness);
+        update_fitness();
+    }
+
+    step_count++;
+    population.age.compact(step_count);
 }
 
+void World::rebuild_grid() {
+    auto alive = [&](size_t i) { return agents.alive(i); };
+    if (config && config->incremental_grid) {
+        grid->update(agents.pos_x.data(), agents.pos_y.data(), agents.size(), alive);
+    } else {
+        grid->rebuild(agents.pos_x.data(), agents.pos_y.data(), agents.size(), alive);
+    }
+}
+
+static constexpr size_t NO_CLAIM = static_cast<size_t>(-1);
+
+// Interactions read positions frozen at the start of the phase and only write
+// the processing agent's own velocity. Eating is resolved through claims: each
+// prey records the lowest-index predator within eating range, and claims are
+// applied afterwards in index order.
 void World::handle_interactions(double dt) {
     if (!config) return;
 
-    // Rebuild spatial grid
-    grid->clear();
-    for (size_t i = 0; i < agents.size(); ++i) {
-        if (agents[i].alive) {
-            grid->insert(i, agents[i].pos);
-        }
-    }
+    const size_t n = agents.size();
+    eaten_by_.assign(n, NO_CLAIM);
+
+    const Real interaction_range = static_cast<Real>(config->interaction_range);
+    const Real eating_range = static_cast<Real>(config->eating_range);
+    const Real separation_range = static_cast<Real>(config->separation_range);
+    const Real chase = static_cast<Real>(config->predator_chase_strength);
+    const Real flee = static_cast<Real>(config->prey_flee_strength);
+    const Real separation = static_cast<Real>(config->separation_strength);
+    const Real radius = std::sqrt(std::max({interaction_range, eating_range, separation_range}));
+    const bool scripted = !config->enable_ai;
 
     // Process interactions using spatial grid
-    for (size_t i = 0; i < agents.size(); ++i) {
-        auto& a = agents[i];
-        if (!a.alive) continue;
-
-        grid->query_radius(a.pos, std::sqrt(config->interaction_range), [&](size_t j) {
-            if (i == j) return;
-            auto& b = agents[j];
-            if (!b.alive) return;
-
-            double dx = b.pos.x - a.pos.x;
-            double dy = b.pos.y - a.pos.y;
-            double dist2 = dx*dx + dy*dy + 1e-6;
-
-            // Predator chases prey (only if AI is disabled)
-            if (!config->enable_ai) {
-                if (a.predator && !b.predator && dist2 < config->interaction_range) {
-                    a.vel.x += config->predator_chase_strength * dx;
-                    a.vel.y += config->predator_chase_strength * dy;
-                } 
-                // Prey flees from predator
-                else if (!a.predator && b.predator && dist2 < config->interaction_range) {
-                    a.vel.x -= config->prey_flee_strength * dx;
-                    a.vel.y -= config->prey_flee_strength * dy;
+    pool->parallel_for(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!agents.alive(i)) continue;
+            const bool a_predator = agents.predator[i];
+            const Real ax = agents.pos_x[i];
+            const Real ay = agents.pos_y[i];
+
+            // Velocity change accumulated from all neighbours
+            Real dvx = 0, dvy = 0;
+            size_t claim = NO_CLAIM;
+
+            grid->for_each_in_radius({ax, ay}, radius, [&](size_t j) {
+                if (i == j) return;
+                if (!agents.alive(j)) return;
+                const bool b_predator = agents.predator[j];
+
+                const Real dx = grid->offset(ax, agents.pos_x[j]);
+                const Real dy = grid->offset(ay, agents.pos_y[j]);
+                const Real dist2 = dx*dx + dy*dy + Real(1e-6);
+
+                // Predator chases prey (only if AI is disabled)
+                if (scripted) {
+                    if (a_predator && !b_predator && dist2 < interaction_range) {
+                        dvx += chase * dx;
+                        dvy += chase * dy;
+                    }
+                    // Prey flees from predator
+                    else if (!a_predator && b_predator && dist2 < interaction_range) {
+                        dvx -= flee * dx;
+                        dvy -= flee * dy;
+                    }
                 }
-            }
-            
-            // Eating mechanics (always active)
-            if (a.predator && !b.predator && dist2 < config->eating_range) {
-                b.alive = false;
-                a.energy += config->energy_gain_from_prey;
-                if (a.energy > config->max_energy) a.energy = config->max_energy;
-                a.kills++;
-                if (stats) stats->record_death();
-            }
-            
-            // Separation (avoid crowding)
-            if (dist2 < config->separation_range) {
-                a.vel.x -= config->separation_strength * dx;
-                a.vel.y -= config->separation_strength * dy;
-            }
-        });
+
+                // Eating mechanics (always active): prey claims its eater
+                if (!a_predator && b_predator && dist2 < eating_range && j < claim) {
+                    claim = j;
+                }
+
+                // Separation (avoid crowding)
+                if (dist2 < separation_range) {
+                    dvx -= separation * dx;
+                    dvy -= separation * dy;
+                }
+            });
+
+            agents.vel_x[i] += dvx;
+            agents.vel_y[i] += dvy;
+            eaten_by_[i] = claim;
+        }
+    });
+
+    // Apply claims in prey index order
+    const Real gain = static_cast<Real>(config->energy_gain_from_prey);
+    const Real max_energy = static_cast<Real>(config->max_energy);
+    int eaten = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const size_t p = eaten_by_[i];
+        if (p == NO_CLAIM) continue;
+
+        population.remove_agent(agents, i, step_count);
+        agents.kill(i);
+        const Real before = agents.energy[p];
+        agents.energy[p] = std::min(before + gain, max_energy);
+        population.change_energy(agents.predator[p], before, agents.energy[p]);
+        population.kills.move(population.kills.bucket(agents.kills[p]), population.kills.bucket(agents.kills[p] + 1));
+        agents.kills[p]++;
+        eaten++;
     }
+    if (stats && eaten > 0) stats->record_death(eaten);
 }
 
 void World::integrate_movement(double dt) {
-    for (auto& a : agents) {
-        if (!a.alive) continue;
-
-        // Update trail
-        if (config && config->show_trails) {
-            a.trail.push_back(a.pos);
-            if (a.trail.size() > static_cast<size_t>(config->trail_length)) {
-                a.trail.pop_front();
+    const bool trails = config && config->show_trails;
+    const size_t trail_length = config ? static_cast<size_t>(std::max(config->trail_length, 0)) : 0;
+    const size_t n = agents.size();
+
+    // Trails record the position before the move; turning them off frees
+    // the buffer
+    agents.trails.set_length(trails ? trail_length : 0, n);
+    if (trails) {
+        pool->parallel_for(n, [&](size_t begin, size_t end) {
+            agents.trails.write(agents.pos_x.data(), agents.pos_y.data(), begin, end);
+        }, 4096);
+        agents.trails.advance();
+    }
+
+    // Move, bounce off the walls and clamp (or in a wrapping world re-enter
+    // at the opposite edge, within [-boundary, boundary)), VecR::width agents
+    // at a time. Agents killed this step move too; they are dropped at
+    // compaction. A block shorter than the vector width goes through a padded
+    // copy, so every agent sees the same instructions whatever the chunking.
+    const bool wrap = grid->wraps();
+    const VecR vdt = VecR::broadcast(static_cast<Real>(dt));
+    const VecR hi = VecR::broadcast(static_cast<Real>(boundary));
+    const VecR lo = VecR::broadcast(static_cast<Real>(-boundary));
+    const VecR period = VecR::broadcast(static_cast<Real>(2.0 * boundary));
+    const VecR flip = VecR::broadcast(Real(-1));
+    const Real wrap_hi = static_cast<Real>(boundary);
+    const Real wrap_period = static_cast<Real>(2.0 * boundary);
+    auto move = [&](Real* p, Real* v) {
+        VecR pos = VecR::load(p);
+        VecR vel = VecR::load(v);
+        pos = fmadd(vel, vdt, pos);
+        if (wrap) {
+            pos = select_gt(lo, pos, pos + period, pos);
+            select_gt(hi, pos, pos, pos - period).store(p);
+
+            // An agent faster than one period per step is still outside;
+            // fold it back with a full modulo
+            for (size_t k = 0; k < VecR::width; ++k) {
+                if (!(p[k] < -wrap_hi || p[k] >= wrap_hi)) continue;  // Also keeps NaN
+                p[k] -= wrap_period * std::floor((p[k] + wrap_hi) / wrap_period);
+                if (p[k] >= wrap_hi) p[k] -= wrap_period;
+                if (p[k] < -wrap_hi) p[k] += wrap_period;
             }
-        } else {
-            a.trail.clear();
+            return;
         }
+        vel = select_gt(pos, hi, vel * flip, select_gt(lo, pos, vel * flip, vel));
+        vmin(vmax(pos, lo), hi).store(p);
+        vel.store(v);
+    };
 
-        a.pos.x += a.vel.x * dt;
-        a.pos.y += a.vel.y * dt;
-        
-        // Wall bounce
-        if (a.pos.x > boundary || a.pos.x < -boundary) a.vel.x *= -1;
-        if (a.pos.y > boundary || a.pos.y < -boundary) a.vel.y *= -1;
-        
-        // Clamp position
-        a.pos.x = std::clamp(a.pos.x, -boundary, boundary);
-        a.pos.y = std::clamp(a.pos.y, -boundary, boundary);
-    }
+    pool->parallel_for(n, [&](size_t begin, size_t end) {
+        constexpr size_t W = VecR::width;
+        size_t i = begin;
+        for (; i + W <= end; i += W) {
+            move(&agents.pos_x[i], &agents.vel_x[i]);
+            move(&agents.pos_y[i], &agents.vel_y[i]);
+        }
+        if (i == end) return;
+
+        const size_t rest = end - i;
+        Real px[W] = {}, py[W] = {}, vx[W] = {}, vy[W] = {};
+        std::copy_n(&agents.pos_x[i], rest, px);
+        std::copy_n(&agents.pos_y[i], rest, py);
+        std::copy_n(&agents.vel_x[i], rest, vx);
+        std::copy_n(&agents.vel_y[i], rest, vy);
+        move(px, vx);
+        move(py, vy);
+        std::copy_n(px, rest, &agents.pos_x[i]);
+        std::copy_n(py, rest, &agents.pos_y[i]);
+        std::copy_n(vx, rest, &agents.vel_x[i]);
+        std::copy_n(vy, rest, &agents.vel_y[i]);
+    }, 4096);
 }
 
 void World::handle_energy_and_reproduction(double dt) {
     if (!config) return;
 
-    std::vector<Agent> new_agents;
+    // Newborns are appended behind the current population and are not
+    // processed until the next step
+    const size_t parents = agents.size();
+    reproduces_.assign(parents, 0);
 
-    for (auto& a : agents) {
-        if (!a.alive) continue;
+    const Real consumption = static_cast<Real>(config->energy_consumption_rate * dt);
+    const Real threshold = static_cast<Real>(config->reproduction_energy_threshold);
+    const Real cost = static_cast<Real>(config->reproduction_energy_cost);
+    std::atomic<int> starved{0};
 
-        // Consume energy
-        a.energy -= config->energy_consumption_rate * dt;
+    // Population energy sums and histogram moves are gathered per chunk and
+    // applied once at its end
+    pool->parallel_for(parents, [&](size_t begin, size_t end) {
+        int local_starved = 0;
+        PopulationStats::EnergyBatch energy_changes(population);
+        for (size_t i = begin; i < end; ++i) {
+            if (!agents.alive(i)) continue;
+            const bool predator = agents.predator[i];
+            const Real before = agents.energy[i];
 
-        // Death from starvation
-        if (a.energy <= 0.0) {
-            a.alive = false;
-            if (stats) stats->record_death();
-            continue;
-        }
+            // Consume energy
+            agents.energy[i] -= consumption;
 
-        // Reproduction
-        if (a.energy >= config->reproduction_energy_threshold) {
-            a.energy -= config->reproduction_energy_cost;
-            
-            Agent offspring;
-            offspring.pos = a.pos;
-            offspring.vel = {a.vel.x * 0.9, a.vel.y * 0.9};
-            offspring.predator = a.predator;
-            offspring.energy = config->reproduction_energy_cost * 0.5;
-            offspring.alive = true;
-            offspring.generation = a.generation + 1;
-            
-            // Inherit and mutate brain
-            if (config->enable_ai && a.brain) {
-                offspring.brain = std::make_unique<NeuralNetwork>(a.brain->clone());
-                offspring.brain->mutate(config->mutation_rate, config->mutation_strength);
-            } else if (config->enable_ai) {
-                // Parent has no brain, create new one
-                std::random_device rd;
-                initialize_brain(offspring, rd());
+            // Death from starvation
+            if (agents.energy[i] <= 0) {
+                population.change_energy(predator, before, agents.energy[i]);
+                population.remove_agent(agents, i, step_count);
+                agents.kill(i);
+                local_starved++;
+                continue;
             }
-            
-            new_agents.push_back(std::move(offspring));
-            if (stats) stats->record_birth();
+
+            // Reproduction
+            if (agents.energy[i] >= threshold) {
+                agents.energy[i] -= cost;
+                reproduces_[i] = 1;
+            }
+
+            energy_changes.change(predator, before, agents.energy[i]);
         }
+        starved.fetch_add(local_starved, std::memory_order_relaxed);
+    });
+    if (stats && starved > 0) stats->record_death(starved);
+
+    // Append offspring in parent order so slot and id assignment is
+    // deterministic. A child's mutation only depends on its id and the step.
+    std::vector<size_t> parent_of;
+    for (size_t i = 0; i < parents; ++i) {
+        if (!reproduces_[i]) continue;
+        agents.add(next_agent_id++,
+                   agents.pos(i),
+                   {agents.vel_x[i] * Real(0.9), agents.vel_y[i] * Real(0.9)},
+                   agents.predator[i],
+                   cost * Real(0.5),
+                   agents.generation[i] + 1);
+        parent_of.push_back(i);
     }
+    if (parent_of.empty()) return;
+    population.add_agents(agents, parents, agents.size(), step_count);
 
-    // Add newborns to population
-    for (auto& offspring : new_agents) {
-        agents.push_back(std::move(offspring));
+    // Inherit and mutate brains. Blocks are taken from the pool serially
+    // (the free list is shared), then filled in parallel; each child only
+    // touches its own block.
+    if (config->enable_ai) {
+        for (size_t k = 0; k < parent_of.size(); ++k) {
+            agents.brain[parents + k] = brains->allocate();
+        }
+        pool->parallel_for(parent_of.size(), [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                const BrainHandle parent = agents.brain[parent_of[k]];
+                const BrainHandle child = agents.brain[parents + k];
+                const uint64_t id = agents.id[parents + k];
+                if (parent != NO_BRAIN) {
+                    brains->copy(child, parent);
+                    brains->mutate(child, config->mutation_rate, config->mutation_strength,
+                                   CounterRng(seed, id, step_count, RngStream::Mutation));
+                } else {
+                    // Parent has no brain, create new one
+                    brains->init(child, CounterRng(seed, id, step_count, RngStream::BrainInit));
+                }
+            }
+        }, 64);
     }
+
+    if (stats) stats->record_birth(static_cast<int>(parent_of.size()));
 }
 
 void World::remove_dead_agents() {
-    agents.erase(
-        std::remove_if(agents.begin(), agents.end(),
-                      [](const Agent& a) { return !a.alive; }),
-        agents.end()
-    );
-}
+    // Return the dead agents' brains to the pool before their handles go
+    for (size_t i = 0; i < agents.size(); ++i) {
+        if (!agents.alive(i) && agents.brain[i] != NO_BRAIN) brains->release(agents.brain[i]);
+    }
 
-int World::count_predators() const {
-    return std::count_if(agents.begin(), agents.end(),
-                        [](const Agent& a) { return a.predator && a.alive; });
+    // Survivors keep their grid cells, so the next update only moves movers
+    if (config && config->incremental_grid) {
+        grid->compact(agents.size(), [&](size_t i) { return agents.alive(i); });
+    }
+    agents.remove_dead();
 }
 
-int World::count_prey() const {
-    return std::count_if(agents.begin(), agents.end(),
-                        [](const Agent& a) { return !a.predator && a.alive; });
+void World::update_fitness() {
+    pool->parallel_for(agents.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (agents.alive(i)) {
+                agents.age[i]++;
+                agents.fitness[i] = agents.age[i] * Real(0.1) + agents.energy[i] * Real(0.5) + agents.kills[i] * Real(10);
+            }
+        }
+    });
 }
 
 void World::spawn_prey(int count) {
-    if (!config) return;
-    
-    std::mt19937 rng(static_cast<unsigned>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
-    std::uniform_real_distribution<double> dist(-1.0, 1.0);
-    
-    for (int i = 0; i < count; ++i) {
-        Agent a;
-        a.pos = {dist(rng) * boundary, dist(rng) * boundary};
-        a.vel = {dist(rng), dist(rng)};
-        a.predator = false;
-        a.energy = config->initial_energy;
-        a.alive = true;
-        a.generation = generation_counter;
-        
-        if (config->enable_ai) {
-            initialize_brain(a, rng());
-        }
-        
-        agents.push_back(std::move(a));
-        if (stats) stats->record_birth();
-    }
+    spawn_agents(count, false);
 }
 
 void World::spawn_predators(int count) {
+    spawn_agents(count, true);
+}
+
+void World::spawn_agents(int count, bool predators) {
     if (!config) return;
-    
-    std::mt19937 rng(static_cast<unsigned>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
-    std::uniform_real_distribution<double> dist(-1.0, 1.0);
-    
+    if (recorder) recorder->record_spawn(step_count, predators, count);
+
     for (int i = 0; i < count; ++i) {
-        Agent a;
-        a.pos = {dist(rng) * boundary, dist(rng) * boundary};
-        a.vel = {dist(rng), dist(rng)};
-        a.predator = true;
-        a.energy = config->initial_energy;
-        a.alive = true;
-        a.generation = generation_counter;
-        
+        const uint64_t id = next_agent_id++;
+        CounterRng layout(seed, id, step_count, RngStream::Layout);
+        const size_t idx = agents.add(id, {}, {}, predators, static_cast<Real>(config->initial_energy),
+                                      generation_counter);
+        place_randomly(idx, layout);
+        population.add_agent(agents, idx, step_count);
+
         if (config->enable_ai) {
-            initialize_brain(a, rng());
+            initialize_brain(idx);
         }
-        
-        agents.push_back(std::move(a));
+
         if (stats) stats->record_birth();
     }
 }
 
+void World::place_randomly(size_t agent_idx, CounterRng& rng) {
+    agents.pos_x[agent_idx] = static_cast<Real>(rng.uniform(-1.0, 1.0) * boundary);
+    agents.pos_y[agent_idx] = static_cast<Real>(rng.uniform(-1.0, 1.0) * boundary);
+    agents.vel_x[agent_idx] = static_cast<Real>(rng.uniform(-1.0, 1.0));
+    agents.vel_y[agent_idx] = static_cast<Real>(rng.uniform(-1.0, 1.0));
+}
+
 // AI Methods Implementation
-void World::initialize_brain(Agent& agent, unsigned seed) {
-    if (!config) return;
-    agent.brain = std::make_unique<NeuralNetwork>(
-        config->neural_input_size,
-        config->neural_hidden_size,
-        config->neural_output_size,
-        seed
-    );
+// The network topology is fixed when the World is created so every brain
+// fits the batched inference layout
+void World::initialize_brain(size_t agent_idx) {
+    brains->release(agents.brain[agent_idx]);
+    agents.brain[agent_idx] = brains->create(CounterRng(seed, agents.id[agent_idx], step_count,
+                                                        RngStream::BrainInit));
 }
 
-std::vector<double> World::get_agent_inputs(const Agent& agent, size_t agent_idx) {
-    std::vector<double> inputs(config->neural_input_size, 0.0);
-    
-    // Find nearest prey, predator, and any agent
-    double nearest_prey_dist = 1e9;
-    double nearest_predator_dist = 1e9;
-    double nearest_agent_dist = 1e9;
-    Vec2 nearest_prey = {0, 0};
-    Vec2 nearest_predator = {0, 0};
-    Vec2 nearest_agent = {0, 0};
-    
-    for (size_t i = 0; i < agents.size(); ++i) {
-        if (i == agent_idx || !agents[i].alive) continue;
-        
-        const auto& other = agents[i];
-        double dx = other.pos.x - agent.pos.x;
-        double dy = other.pos.y - agent.pos.y;
-        double dist = std::sqrt(dx*dx + dy*dy);
-        
-        // Track nearest prey
-        if (!other.predator && dist < nearest_prey_dist) {
-            nearest_prey_dist = dist;
-            nearest_prey = {dx, dy};
-        }
-        
-        // Track nearest predator
-        if (other.predator && dist < nearest_predator_dist) {
-            nearest_predator_dist = dist;
-            nearest_predator = {dx, dy};
-        }
-        
-        // Track nearest any agent
-        if (dist < nearest_agent_dist) {
-            nearest_agent_dist = dist;
-            nearest_agent = {dx, dy};
-        }
-    }
-    
+void World::get_agent_inputs(size_t agent_idx, int num_prey, int num_predators, Real* inputs) const {
+    const Real ax = agents.pos_x[agent_idx];
+    const Real ay = agents.pos_y[agent_idx];
+    const bool self_predator = agents.predator[agent_idx];
+
+    // Find nearest prey and predator through the grid; the nearest agent of
+    // any kind is whichever of the two is closer. Classes with no other
+    // members are not searched at all.
+    constexpr int PREY = 0, PREDATOR = 1;
+    unsigned class_mask = 0;
+    if (num_prey - (self_predator ? 0 : 1) > 0) class_mask |= 1u << PREY;
+    if (num_predators - (self_predator ? 1 : 0) > 0) class_mask |= 1u << PREDATOR;
+
+    NearestHit hits[2];
+    grid->query_nearest_per_class({ax, ay}, agents.pos_x.data(), agents.pos_y.data(),
+        [&](size_t j) {
+            if (j == agent_idx || !agents.alive(j)) return -1;
+            return agents.predator[j] ? PREDATOR : PREY;
+        },
+        hits, 2, class_mask);
+
+    auto offset_to = [&](const NearestHit& hit) -> Vec2 {
+        if (!hit.found()) return {0, 0};
+        return {grid->offset(ax, agents.pos_x[hit.index]), grid->offset(ay, agents.pos_y[hit.index])};
+    };
+
+    const NearestHit& prey_hit = hits[PREY];
+    const NearestHit& predator_hit = hits[PREDATOR];
+    const bool prey_closer = prey_hit.dist2 < predator_hit.dist2 ||
+        (prey_hit.dist2 == predator_hit.dist2 && prey_hit.index < predator_hit.index);
+
+    Vec2 nearest_prey = offset_to(prey_hit);
+    Vec2 nearest_predator = offset_to(predator_hit);
+    Vec2 nearest_agent = prey_closer ? nearest_prey : nearest_predator;
+
     // Normalize inputs to [-1, 1] range
-    double norm_factor = 1.0 / (boundary * 2.0);
-    
-    inputs[0] = nearest_prey.x * norm_factor;
-    inputs[1] = nearest_prey.y * norm_factor;
-    inputs[2] = nearest_predator.x * norm_factor;
-    inputs[3] = nearest_predator.y * norm_factor;
-    inputs[4] = nearest_agent.x * norm_factor;
-    inputs[5] = nearest_agent.y * norm_factor;
-    inputs[6] = (agent.energy / config->max_energy) * 2.0 - 1.0;  // -1 to 1
-    inputs[7] = std::tanh(std::sqrt(agent.vel.x*agent.vel.x + agent.vel.y*agent.vel.y));  // velocity magnitude
-    
-    return inputs;
+    const Real norm_factor = static_cast<Real>(1.0 / (boundary * 2.0));
+    const Real max_energy = static_cast<Real>(config->max_energy);
+
+    const Real vx = agents.vel_x[agent_idx];
+    const Real vy = agents.vel_y[agent_idx];
+
+    const Real features[] = {
+        nearest_prey.x * norm_factor,
+        nearest_prey.y * norm_factor,
+        nearest_predator.x * norm_factor,
+        nearest_predator.y * norm_factor,
+        nearest_agent.x * norm_factor,
+        nearest_agent.y * norm_factor,
+        (agents.energy[agent_idx] / max_energy) * 2 - 1,  // -1 to 1
+        std::tanh(std::sqrt(vx*vx + vy*vy)),  // velocity magnitude
+    };
+
+    // Networks wider than the feature set see zeros in the extra inputs
+    const int input_size = inference_->shape().input;
+    constexpr int num_features = sizeof(features) / sizeof(features[0]);
+    for (int k = 0; k < input_size; ++k) {
+        inputs[k] = k < num_features ? features[k] : Real(0);
+    }
 }
 
 void World::apply_neural_control(double dt) {
     if (!config) return;
-    
-    for (size_t i = 0; i < agents.size(); ++i) {
-        auto& a = agents[i];
-        if (!a.alive || !a.brain) continue;
-        
-        // Get sensory inputs
-        auto inputs = get_agent_inputs(a, i);
-        
-        // Forward pass through neural network
-        auto outputs = a.brain->forward(inputs);
-        
-        // Apply outputs as acceleration (scaled)
-        double accel_scale = 0.05;  // Control responsiveness
-        a.vel.x += outputs[0] * accel_scale;
-        a.vel.y += outputs[1] * accel_scale;
-        
-        // Limit velocity
-        double max_vel = 2.0;
-        double vel_mag = std::sqrt(a.vel.x*a.vel.x + a.vel.y*a.vel.y);
-        if (vel_mag > max_vel) {
-            a.vel.x = (a.vel.x / vel_mag) * max_vel;
-            a.vel.y = (a.vel.y / vel_mag) * max_vel;
-        }
+
+    const size_t n = agents.size();
+    const int num_predators = count_predators();
+    const int num_prey = count_prey();
+    const int num_outputs = inference_->shape().output;
+
+    // Sensing: one input row per brain-driven agent. Sensing reads positions
+    // only, so agents can be processed in any order.
+    {
+        ScopedPhase scope(profiler, Phase::Sensing);
+        inference_->resize(n);
+        pool->parallel_for(n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (!agents.alive(i) || agents.brain[i] == NO_BRAIN) continue;
+                get_agent_inputs(i, num_prey, num_predators, inference_->input_row(i));
+                inference_->bind(i, brains->params(agents.brain[i]));
+            }
+        }, 256);
     }
-}
 
+    // Forward pass for the whole population at once, then apply the outputs
+    ScopedPhase scope(profiler, Phase::NeuralNet);
+    inference_->run(*pool);
+
+    // Apply outputs as acceleration; each agent writes only its own velocity
+    pool->parallel_for(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!agents.alive(i) || agents.brain[i] == NO_BRAIN) continue;
+            const Real* outputs = inference_->output_row(i);
+
+            Real& vx = agents.vel_x[i];
+            Real& vy = agents.vel_y[i];
+
+            // Apply outputs as acceleration (scaled)
+            const Real accel_scale = Real(0.05);  // Control responsiveness
+            vx += outputs[0] * accel_scale;
+            if (num_outputs > 1) vy += outputs[1] * accel_scale;
+
+            // Limit velocity
+            const Real max_vel = 2;
+            const Real vel_mag = std::sqrt(vx*vx + vy*vy);
+            if (vel_mag > max_vel) {
+                vx = (vx / vel_mag) * max_vel;
+                vy = (vy / vel_mag) * max_vel;
+            }
+        }
+    });
+}
@@ -1,39 +1,71 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <memory>
-#include "agent.hpp"
+#include "agent_store.hpp"
 #include "config.hpp"
 #include "spatial_grid.hpp"
+#include "population_stats.hpp"
+#include "rng.hpp"
 
 class Statistics;
+class Profiler;
+class ReplayRecorder;
+class ThreadPool;
+class BatchedInference;
 
 struct World {
-    std::vector<Agent> agents;
+    AgentStore agents;
+    PopulationStats population;  // Live counts, energy sums and distributions, kept current
     double boundary = 6.0;
     SimulationConfig* config = nullptr;
     Statistics* stats = nullptr;
+    Profiler* profiler = nullptr;  // Optional; times each phase of update()
+    ReplayRecorder* recorder = nullptr;  // Optional; logs external inputs (spawns)
     std::unique_ptr<SpatialGrid> grid;
+    std::unique_ptr<ThreadPool> pool;  // Sized from config.num_threads at construction
+    std::unique_ptr<BrainPool> brains;  // Parameter blocks behind agents.brain handles
     int generation_counter = 0;
+    unsigned seed = 0;        // Seed the world was created with
+    uint64_t step_count = 0;  // Completed calls to update()
+    uint64_t next_agent_id = 0;  // Id of the next agent created (saved in checkpoints)
 
     World(const SimulationConfig& cfg, unsigned seed);
+    ~World();
     void update(double dt);
     void set_statistics(Statistics* s) { stats = s; }
+    void set_profiler(Profiler* p) { profiler = p; }
+    void set_recorder(ReplayRecorder* r) { recorder = r; }
     
     // Spawning methods
     void spawn_prey(int count);
     void spawn_predators(int count);
     
-    int count_predators() const;
-    int count_prey() const;
+    int count_predators() const { return population.predators(); }
+    int count_prey() const { return population.prey(); }
 
 private:
+    friend struct WorldPhaseBench;  // Times the phases individually (bench_main.cpp)
+
+    void rebuild_grid();
     void handle_interactions(double dt);
     void integrate_movement(double dt);
     void handle_energy_and_reproduction(double dt);
     void remove_dead_agents();
+    void update_fitness();  // Age and fitness of survivors
     
     // AI methods
     void apply_neural_control(double dt);
-    std::vector<double> get_agent_inputs(const Agent& agent, size_t agent_idx);
-    void initialize_brain(Agent& agent, unsigned seed);
+    void get_agent_inputs(size_t agent_idx, int num_prey, int num_predators, Real* inputs) const;
+    void initialize_brain(size_t agent_idx);
+
+    // Random position and velocity from the agent's Layout stream
+    void place_randomly(size_t agent_idx, CounterRng& rng);
+    void spawn_agents(int count, bool predators);
+
+    std::unique_ptr<BatchedInference> inference_;  // Input/output matrices for all brains
+
+    // Per-step scratch, reused across steps
+    std::vector<size_t> eaten_by_;     // Predator claiming each prey (or NO_CLAIM)
+    std::vector<uint8_t> reproduces_;  // Set for parents giving birth this step
 };